@@ -0,0 +1,98 @@
+///
+// chunkMap.h a C/C++ interface for a concurrent map keyed by the integer
+// coordinates of a chunk
+// Any number of threads may look values up while others add and remove
+// them. Lookups take no locks; writers lock only the stripe of the map their
+// key falls in. Anything a writer unlinks is freed once no reader can still
+// be looking at it (epoch based reclamation).
+//
+// Readers pin the map for as long as they use what they look up:
+//
+//     int pin = chunkMapPin(map);
+//     Chunk *chunk = (Chunk *)chunkMapGet(map, x, y);
+//     ... use chunk ...
+//     chunkMapUnpin(map, pin);
+//
+// Author: T. Wilgenbusch
+///
+
+#ifndef _CHUNKMAP_H_
+#define _CHUNKMAP_H_
+
+#include <stdbool.h>
+
+/// The number of independently locked stripes of a map
+#define CHUNK_MAP_STRIPES 16
+
+/// The most threads that may have a map pinned at once
+#define CHUNK_MAP_READERS 64
+
+/// Opaque handle for a map
+typedef struct chunkMap *ChunkMap;
+
+///
+// makeChunkMap - creates a new empty map
+// @param releaseValue called on a value once it has been replaced or removed
+//   and no reader can still be using it (may be NULL)
+// @return a new ChunkMap pointer
+///
+ChunkMap makeChunkMap(void (*releaseValue)(void *val));
+
+///
+// destroyChunkMap - deallocates all the memory associated with a map; no
+// thread may be using it. Values still in the map are not released.
+// @param map the map being destroyed
+///
+void destroyChunkMap(ChunkMap map);
+
+///
+// chunkMapPin - starts a read of a map; nothing looked up is freed before the
+// matching chunkMapUnpin()
+// @param map the map being read
+// @return the pin, to be handed to chunkMapUnpin()
+///
+int chunkMapPin(ChunkMap map);
+
+///
+// chunkMapUnpin - ends a read of a map started by chunkMapPin()
+// @param map the map being read
+// @param pin the pin returned by chunkMapPin()
+///
+void chunkMapUnpin(ChunkMap map, int pin);
+
+///
+// chunkMapGet - grabs the value at (x, y) from a map; the caller must have
+// the map pinned, and may only use the value until it unpins it
+// @param map the map we are searching through
+// @param x, y the coordinates of the value we are getting
+// @return the value at (x, y), or if no value was found NULL
+///
+void *chunkMapGet(ChunkMap map, int x, int y);
+
+///
+// chunkMapPut - puts a value into a map at (x, y); a value already there is
+// replaced and released once no reader can be using it
+// @param map the map we are updating
+// @param x, y the coordinates the value is stored under
+// @param val the value being put into the map
+///
+void chunkMapPut(ChunkMap map, int x, int y, void *val);
+
+///
+// chunkMapRemove - takes the value at (x, y) out of a map; it is released
+// once no reader can be using it
+// @param map the map we are updating
+// @param x, y the coordinates of the value being removed
+// @return true if there was a value to remove, otherwise false
+///
+bool chunkMapRemove(ChunkMap map, int x, int y);
+
+///
+// chunkMapCollect - frees whatever has been removed from a map and is no
+// longer pinned by any reader; writers do this as they go, so this is only
+// needed to clean up after the last write
+// @param map the map being cleaned up
+///
+void chunkMapCollect(ChunkMap map);
+
+#endif
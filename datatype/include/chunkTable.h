@@ -0,0 +1,138 @@
+///
+// chunkTable.h a C/C++ interface for a hash table keyed by the integer
+// coordinates of a chunk
+// This table uses open addressing: entries live in one array, and a byte of
+// metadata per slot lets a whole group of slots be checked at once
+//
+// Author: T. Wilgenbusch
+///
+
+#ifndef _CHUNKTABLE_H_
+#define _CHUNKTABLE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// The number of slots whose metadata is checked at once
+#define CHUNK_TABLE_GROUP 16
+
+///
+// hashChunkCoord - hashes a pair of chunk coordinates; the two 32 bit 
+// coordinates are packed into one 64 bit word and mixed by a multiply, whose 
+// well mixed top half is then folded into the bottom, so both ends of the 
+// hash depend on both coordinates. Inline so that lookups never call through 
+// a function pointer.
+// @param x, y the coordinates being hashed
+// @return the hash
+///
+static inline uint64_t hashChunkCoord(int x, int y)
+{
+    uint64_t h = ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+    h *= 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 32);
+}
+
+/// Metadata of a slot that has never held a value, and of one whose value 
+/// was removed; full slots have a metadata byte from 0 to 127
+#define CHUNK_CTRL_EMPTY ((signed char)-128)
+#define CHUNK_CTRL_DELETED ((signed char)-2)
+
+///
+// chunkCtrlOf - gets the metadata byte of a full slot from the hash of its 
+// key; the top 7 bits, since the low ones pick where the key is probed from
+// @param hash the hash of the key, from hashChunkCoord()
+// @return the metadata byte
+///
+static inline signed char chunkCtrlOf(uint64_t hash)
+{
+    return (signed char)(hash >> 57);
+}
+
+///
+// Structure for a slot of the table; the key is stored in place
+// x, y - the coordinates the value is stored under
+// val - the value being stored
+///
+typedef struct ChunkTableSlot
+{
+    int x, y;
+    void *val;
+}ChunkTableSlot;
+
+///
+// Structure representing the table
+// capacity the number of slots; a power of two, and a whole number of groups
+// size the number of values currently in the table
+// deleted the number of slots emptied by chunkTableRemove() but not yet
+//   reused
+// ctrl the metadata byte of every slot: empty, deleted, or the top 7 bits of
+//   the hash of the key in the slot
+// slots the slots themselves
+///
+struct chunkTable
+{
+    unsigned long capacity;
+    unsigned long size;
+    unsigned long deleted;
+    signed char *ctrl;
+    ChunkTableSlot *slots;
+};
+
+/// Creating a typedef for the chunkTable struct pointer
+typedef struct chunkTable *ChunkTable;
+
+///
+// makeChunkTable - creates a new empty table
+// @param initialSize the number of values the table should hold before it
+//   has to grow
+// @return a new ChunkTable pointer
+///
+ChunkTable makeChunkTable(unsigned long initialSize);
+
+///
+// destroyChunkTable - deallocates all the memory associated with a table;
+// the values are not freed
+// @param table the table being destroyed
+///
+void destroyChunkTable(ChunkTable table);
+
+///
+// chunkTableContains - determines if there is a value at (x, y) in a table
+// @param table - the table we are searching through
+// @param x, y - the coordinates we are looking for
+// @return true if (x, y) is already in table, otherwise false
+///
+bool chunkTableContains(ChunkTable table, int x, int y);
+
+///
+// chunkTablePut - puts a value into a table at (x, y), replacing any value
+// already there; the table grows in place, so the pointer stays valid
+// @param table the table we are updating
+// @param x, y the coordinates the value is stored under
+// @param val the value being put into the table
+///
+void chunkTablePut(ChunkTable table, int x, int y, void *val);
+
+///
+// chunkTableGet - grabs the value at (x, y) from a table
+// @param table the table we are searching through
+// @param x, y the coordinates of the value we are getting
+// @return the value at (x, y), or if no value was found NULL
+///
+void *chunkTableGet(ChunkTable table, int x, int y);
+
+///
+// chunkTableRemove - takes the value at (x, y) out of a table
+// @param table the table we are updating
+// @param x, y the coordinates of the value being removed
+// @return true if there was a value to remove, otherwise false
+///
+bool chunkTableRemove(ChunkTable table, int x, int y);
+
+///
+// printChunkTable - prints the current table to std-out (used for debugging)
+// @param table the table being printed
+///
+void printChunkTable(ChunkTable table);
+
+#endif
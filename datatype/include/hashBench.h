@@ -0,0 +1,20 @@
+///
+// hashBench.h a C/C++ interface for timing the hash table lookups
+// Run it with "./main --hash-bench"; it needs no window or openGL context.
+//
+// Author: T. Wilgenbusch
+///
+
+#ifndef _HASHBENCH_H_
+#define _HASHBENCH_H_
+
+///
+// hashBench - fills hash tables from a few thousand up to a few million
+// entries, well past the size of the L2 cache, and prints the median time 
+// per lookup of a loop of get() calls next to that of getMany() over the 
+// same keys, and of a HASH_TABLE_TYPED table and a ChunkTable holding the 
+// same entries; they take turns running first
+///
+void hashBench();
+
+#endif
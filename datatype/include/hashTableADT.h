@@ -23,6 +23,44 @@ typedef struct Entry
     void *val;
 }Entry;
 
+///
+// Structure for a slab of entries; entries are handed out from slabs rather 
+// than malloc()ed one at a time, and freed a whole slab at a time when the 
+// table is destroyed
+// next - the slab before this one
+// count - the number of entries in the slab
+// entries - the entries, allocated along with the slab
+///
+typedef struct EntrySlab
+{
+    struct EntrySlab *next;
+    unsigned long count;
+    Entry *entries;
+}EntrySlab;
+
+/// The number of chain lengths counted by getStats(); the last one counts 
+/// every chain at least that long
+#define HASH_STATS_CHAINS 8
+
+///
+// Structure for the counters kept by a hash table when compiled with 
+// HASH_TABLE_STATS defined; define it for every file including this header, 
+// since it changes the layout of the table
+// lookups the number of lookups done by contains(), get() and put()
+// hits the number of those that found their key
+// hitProbes the keys compared by the lookups that found their key
+// missProbes the keys compared by the lookups that did not
+// resizeNanos the time spent growing the table, in nanoseconds
+///
+typedef struct HashTableCounters
+{
+    unsigned long lookups;
+    unsigned long hits;
+    unsigned long hitProbes;
+    unsigned long missProbes;
+    unsigned long long resizeNanos;
+}HashTableCounters;
+
 ///
 // Structure representing the hash table
 // capacity the capacity of the hash table
@@ -31,6 +69,15 @@ typedef struct Entry
 // equal comparison function for comparing to keys
 // printKeyVal prints the contents of a key value pair (for debug purposes)
 // table and array of entries
+// oldTable the table being grown out of, or NULL; while a table grows, its 
+//   entries are moved over a few buckets at a time by put(), and lookups 
+//   check both tables
+// oldCapacity the capacity of oldTable
+// migrated the number of buckets of oldTable already moved over
+// slabs the slabs the entries are allocated from, newest first
+// slabUsed the number of entries of the newest slab handed out
+// resizes the number of times the table has grown
+// counters the lookup and resize counters (only with HASH_TABLE_STATS)
 ///
 struct hashTableADT
 {
@@ -40,11 +87,58 @@ struct hashTableADT
     bool (*equal)(const void* key1, const void* key2);
     void (*printKeyVal)(const void* key, const void* val);
     Entry **table;
+    Entry **oldTable;
+    unsigned long oldCapacity;
+    unsigned long migrated;
+    EntrySlab *slabs;
+    unsigned long slabUsed;
+    unsigned long resizes;
+#ifdef HASH_TABLE_STATS
+    HashTableCounters counters;
+#endif
 };
 
 /// Creating a typedef for the hashTableADT struct pointer
 typedef struct hashTableADT *HashTableADT;
 
+///
+// Structure for the statistics of a hash table, filled in by getStats()
+// size the number of elements in the table
+// capacity the number of buckets
+// loadFactor size / capacity
+// chains the number of chains of each length, from 0 (empty buckets) up; 
+//   the last counts every chain of HASH_STATS_CHAINS - 1 or more
+// maxChain the length of the longest chain
+// hitProbes the average number of keys compared to find a key in the table
+// missProbes the average number of keys compared to find a key is not in 
+//   the table, for keys spread evenly over the buckets
+// resizes the number of times the table has grown
+// growing whether the table is still moving entries into its new buckets
+// counted whether the fields below were measured; they are only kept when 
+//   compiled with HASH_TABLE_STATS defined
+// lookups the number of lookups done so far
+// countedHitProbes, countedMissProbes the average keys compared by the 
+//   lookups done so far that did and did not find their key
+// resizeSeconds the time spent growing the table so far
+///
+typedef struct HashTableStats
+{
+    unsigned long size;
+    unsigned long capacity;
+    double loadFactor;
+    unsigned long chains[HASH_STATS_CHAINS];
+    unsigned long maxChain;
+    double hitProbes;
+    double missProbes;
+    unsigned long resizes;
+    bool growing;
+    bool counted;
+    unsigned long lookups;
+    double countedHitProbes;
+    double countedMissProbes;
+    double resizeSeconds;
+}HashTableStats;
+
 ///
 // create - creates a new empty hash table
 // @param initialCapacity the hash tables initial capacity
@@ -73,10 +167,25 @@ void destroy(HashTableADT hTable);
 bool contains(HashTableADT hTable, void *key);
 
 ///
-// put - puts a key value pair into a hash table
+// containsMany - determines which of a batch of keys are in a hash table; 
+//   the lookups are overlapped, so this is quicker than calling contains() 
+//   on each key once the table no longer fits in the cache
+// @param hTable - the hash table we are searching through
+// @param keys - the keys we are looking for
+// @param count - the number of keys
+// @param found - filled with whether each key is in hTable
+///
+void containsMany(HashTableADT hTable, void **keys, unsigned long count, 
+    bool *found);
+
+///
+// put - puts a key value pair into a hash table; a table that needs to grow 
+//   does so a few buckets per put(), so no single put() stalls on moving 
+//   every entry
 // @param hTable the table we are updating
-//   NOTE: put() requires a double pointer to a hash table struct so that is can
-//         successfully resize the hash table if need be
+//   NOTE: put() takes a double pointer to a hash table struct so that it 
+//         could replace the table when resizing; the table now grows in 
+//         place, so the pointer is never changed
 // @param key the key being put into the hash table
 // @param val the value being put into the hash table
 ///
@@ -90,10 +199,36 @@ void put(HashTableADT *hTable, void *key, void *val);
 ///
 void *get(HashTableADT hTable, void *key);
 
+///
+// getMany - grabs the values associated with a batch of keys from a hash 
+//   table; the lookups are overlapped, so this is quicker than calling get() 
+//   on each key once the table no longer fits in the cache
+// @param hTable the hash table we are searching through
+// @param keys the keys associated with the values we are getting
+// @param count the number of keys
+// @param vals filled with the value associated with each key, or NULL
+///
+void getMany(HashTableADT hTable, void **keys, unsigned long count, 
+    void **vals);
+
 ///
 // printTable - prints the current hash table to std-out (used for debugging)
 // @param hTable the table being printed
 ///
 void printTable(HashTableADT hTable);
 
+///
+// getStats - gathers statistics on how well a hash table spreads its keys; 
+//   walks the buckets, but calls neither the hash nor the equal function
+// @param hTable the table being measured
+// @return the statistics of the table
+///
+HashTableStats getStats(HashTableADT hTable);
+
+///
+// printStats - prints the statistics of a hash table to std-out
+// @param hTable the table being measured
+///
+void printStats(HashTableADT hTable);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,195 @@
+///
+// hashTableTyped.h a C/C++ macro generating a chained hash table specialized
+// for one key and value type
+// The generated table works like hashTableADT, but its hash and equal
+// functions are known at compile time and inline into every probe, and keys
+// and values are stored in place in the entries rather than behind void *.
+// hashTableADT stays the generic version for keys of any type.
+//
+// The entries live in one array in the order they were put, and each bucket
+// chains through them by index, so a put() only allocates when that array
+// or the buckets have to grow, and growing the buckets relinks the chains
+// without touching the allocator.
+//
+// Instantiate it once per key and value type:
+//
+//     static inline uint64_t hashInt(int key) { return key * 2654435761u; }
+//     static inline bool equalInt(int a, int b) { return a == b; }
+//     HASH_TABLE_TYPED(IntTable, int, float, hashInt, equalInt)
+//
+//     IntTable table;
+//     IntTableCreate(&table, 64);
+//     IntTablePut(&table, 7, 1.5f);
+//     float *val = IntTableGet(&table, 7);
+//     IntTableDestroy(&table);
+//
+// Author: T. Wilgenbusch
+///
+
+#ifndef _HASHTABLETYPED_H_
+#define _HASHTABLETYPED_H_
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdint.h>
+
+/// The load factor used when the buckets need to grow
+#define HASH_TABLE_TYPED_LOAD_FACTOR .75
+
+/// The chain index marking the end of a chain
+#define HASH_TABLE_TYPED_END (-1L)
+
+///
+// HASH_TABLE_TYPED - defines a table type Name mapping KeyType to ValType,
+// with these functions:
+//   void NameCreate(Name *table, unsigned long initialCapacity)
+//   void NameDestroy(Name *table)
+//   bool NameContains(const Name *table, KeyType key)
+//   ValType *NameGet(const Name *table, KeyType key) - the value stored in
+//     place, or NULL; valid until the next NamePut()
+//   void NamePut(Name *table, KeyType key, ValType val)
+//
+// @param Name the name of the table type, prefixed to its functions
+// @param KeyType the type of the keys
+// @param ValType the type of the values
+// @param hashKey a function or macro taking a key and giving a uint64_t hash
+// @param equalKey a function or macro taking two keys and giving a bool
+///
+#define HASH_TABLE_TYPED(Name, KeyType, ValType, hashKey, equalKey)          \
+                                                                              \
+/* An entry; next is the index of the next entry in the chain */             \
+typedef struct Name##Entry                                                    \
+{                                                                             \
+    KeyType key;                                                              \
+    ValType val;                                                              \
+    long next;                                                                \
+}Name##Entry;                                                                 \
+                                                                              \
+/* The table; capacity is the number of buckets, a power of two, and each */ \
+/* bucket holds the index of the first entry of its chain */                 \
+typedef struct Name                                                           \
+{                                                                             \
+    unsigned long capacity;                                                   \
+    unsigned long size;                                                       \
+    unsigned long entryCapacity;                                              \
+    long *buckets;                                                            \
+    Name##Entry *entries;                                                     \
+}Name;                                                                        \
+                                                                              \
+/* Points every bucket of a table at the chains of its entries */            \
+static inline void Name##Link(Name *table)                                    \
+{                                                                             \
+    for(unsigned long i = 0; i < table->capacity; i++)                        \
+    {                                                                         \
+        table->buckets[i] = HASH_TABLE_TYPED_END;                             \
+    }                                                                         \
+    for(unsigned long i = 0; i < table->size; i++)                            \
+    {                                                                         \
+        unsigned long index =                                                 \
+            (unsigned long)hashKey(table->entries[i].key) &                   \
+            (table->capacity - 1);                                            \
+        table->entries[i].next = table->buckets[index];                       \
+        table->buckets[index] = (long)i;                                      \
+    }                                                                         \
+}                                                                             \
+                                                                              \
+/* Gives a table room for capacity buckets, and links them up */             \
+static inline void Name##Resize(Name *table, unsigned long capacity)          \
+{                                                                             \
+    long *buckets = (long *)realloc(table->buckets, capacity * sizeof(long)); \
+    if(buckets == NULL)                                                       \
+    {                                                                         \
+        perror( "hash table allocation failed" );                             \
+        exit( 1 );                                                            \
+    }                                                                         \
+    table->buckets = buckets;                                                 \
+    table->capacity = capacity;                                               \
+    Name##Link(table);                                                        \
+}                                                                             \
+                                                                              \
+static inline void Name##Create(Name *table, unsigned long initialCapacity)   \
+{                                                                             \
+    unsigned long capacity = 1;                                               \
+    while(capacity < initialCapacity)                                         \
+    {                                                                         \
+        capacity *= 2;                                                        \
+    }                                                                         \
+    table->size = 0;                                                          \
+    table->entryCapacity = 0;                                                 \
+    table->buckets = NULL;                                                    \
+    table->entries = NULL;                                                    \
+    Name##Resize(table, capacity);                                            \
+}                                                                             \
+                                                                              \
+static inline void Name##Destroy(Name *table)                                 \
+{                                                                             \
+    free(table->buckets);                                                     \
+    free(table->entries);                                                     \
+    table->buckets = NULL;                                                    \
+    table->entries = NULL;                                                    \
+    table->capacity = table->size = table->entryCapacity = 0;                 \
+}                                                                             \
+                                                                              \
+static inline ValType *Name##Get(const Name *table, KeyType key)              \
+{                                                                             \
+    unsigned long index =                                                     \
+        (unsigned long)hashKey(key) & (table->capacity - 1);                  \
+    for(long i = table->buckets[index]; i != HASH_TABLE_TYPED_END;            \
+        i = table->entries[i].next)                                           \
+    {                                                                         \
+        if(equalKey(key, table->entries[i].key))                              \
+        {                                                                     \
+            return &table->entries[i].val;                                    \
+        }                                                                     \
+    }                                                                         \
+    return NULL;                                                              \
+}                                                                             \
+                                                                              \
+static inline bool Name##Contains(const Name *table, KeyType key)             \
+{                                                                             \
+    return Name##Get(table, key) != NULL;                                     \
+}                                                                             \
+                                                                              \
+static inline void Name##Put(Name *table, KeyType key, ValType val)           \
+{                                                                             \
+    /* If the key is already there, update its val */                        \
+    ValType *found = Name##Get(table, key);                                   \
+    if(found != NULL)                                                         \
+    {                                                                         \
+        *found = val;                                                         \
+        return;                                                               \
+    }                                                                         \
+                                                                              \
+    if(table->size == table->entryCapacity)                                   \
+    {                                                                         \
+        unsigned long count =                                                 \
+            table->entryCapacity > 0 ? table->entryCapacity * 2 : 16;         \
+        Name##Entry *entries = (Name##Entry *)realloc(table->entries,         \
+            count * sizeof(Name##Entry));                                     \
+        if(entries == NULL)                                                   \
+        {                                                                     \
+            perror( "hash table allocation failed" );                         \
+            exit( 1 );                                                        \
+        }                                                                     \
+        table->entries = entries;                                             \
+        table->entryCapacity = count;                                         \
+    }                                                                         \
+                                                                              \
+    /* Add the entry at the front of its chain */                            \
+    unsigned long index =                                                     \
+        (unsigned long)hashKey(key) & (table->capacity - 1);                  \
+    Name##Entry *entry = &table->entries[table->size];                        \
+    entry->key = key;                                                         \
+    entry->val = val;                                                         \
+    entry->next = table->buckets[index];                                      \
+    table->buckets[index] = (long)table->size;                                \
+    table->size += 1;                                                         \
+                                                                              \
+    if(table->size >= HASH_TABLE_TYPED_LOAD_FACTOR * table->capacity)         \
+    {                                                                         \
+        Name##Resize(table, table->capacity * 2);                             \
+    }                                                                         \
+}
+
+#endif
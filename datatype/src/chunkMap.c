@@ -0,0 +1,648 @@
+///
+// chunkMap.c a C/C++ implementation for a concurrent map keyed by the
+// integer coordinates of a chunk
+//
+// The map is split into CHUNK_MAP_STRIPES stripes by the hash of the key,
+// each an open addressing table probed a group of slots at a time, like a
+// ChunkTable, with its own writer lock. The metadata bytes of a group are
+// packed into one 64 bit word, so a reader checks a whole group with one
+// atomic load. Readers never lock: a writer fills in a slot before it
+// publishes the slot's metadata with a release store, and readers load the
+// metadata with acquire. A slot's key never changes once published, since
+// removed slots are marked deleted and only reclaimed when the stripe is
+// copied into new slots, which is also how a stripe grows; readers still
+// probing the old slots are unaffected.
+//
+// Whatever a writer unlinks (replaced or removed values, outgrown slots)
+// is retired rather than freed. Retiring bumps the map's epoch, and every
+// pinned reader holds the epoch it pinned at in a slot of its own; a retired
+// item is freed once every pinned reader pinned after it was retired, since
+// those readers found the map with the item already unlinked.
+//
+// Author: T. Wilgenbusch
+///
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "chunkMap.h"
+#include "chunkTable.h"
+
+/// The number of slots whose metadata bytes share one word
+#define MAP_GROUP 8
+
+/// The number of slots a stripe starts with
+#define STRIPE_CAPACITY 16
+
+/// The fraction of the slots of a stripe that may be full or deleted, in
+/// eighths
+#define MAX_LOAD_EIGHTHS 7
+
+/// A word with every metadata byte set to the same value
+#define GROUP_BYTES(ctrl) (0x0101010101010101ull * (uint8_t)(ctrl))
+
+/// Reader slots are padded to a cache line each, so pinning does not bounce
+/// a line shared with other readers between cores
+#define CACHE_LINE 64
+
+///
+// Structure for the slots of a stripe
+// capacity the number of slots; a power of two, and a whole number of groups
+// used the number of slots full or deleted; deleted slots are not reused
+// ctrl the metadata bytes of the slots, a word per group, slot i of a group
+//   in byte i counting from the least significant
+// slots the slots themselves; the key of a full or deleted slot never
+//   changes
+///
+typedef struct MapSlots
+{
+    unsigned long capacity;
+    unsigned long used;
+    uint64_t *ctrl;
+    ChunkTableSlot *slots;
+}MapSlots;
+
+///
+// Structure for a stripe of the map
+// lock held by writers to the stripe
+// slots the current slots of the stripe
+// size the number of values in the stripe
+///
+typedef struct MapStripe
+{
+    pthread_mutex_t lock;
+    MapSlots *slots;
+    unsigned long size;
+}MapStripe;
+
+///
+// Structure for the slot of a pinned reader
+// epoch the epoch the reader pinned at, or 0 if the slot is free
+///
+typedef struct MapReader
+{
+    unsigned long epoch;
+    char pad[CACHE_LINE - sizeof(unsigned long)];
+}MapReader;
+
+///
+// Structure for something unlinked from the map but not yet freed
+// ptr the thing itself
+// release the function that frees it
+// epoch the epoch it was retired in
+///
+typedef struct Retired
+{
+    void *ptr;
+    void (*release)(void *ptr);
+    unsigned long epoch;
+    struct Retired *next;
+}Retired;
+
+///
+// Structure representing the map
+// stripes the stripes of the map
+// readers the slots of the readers
+// epoch the current epoch; starts at 1, so pinned slots are never 0
+// retireLock guards retired
+// retired everything retired but not yet freed
+// releaseValue frees values replaced or removed from the map (may be NULL)
+///
+struct chunkMap
+{
+    MapStripe stripes[CHUNK_MAP_STRIPES];
+    MapReader readers[CHUNK_MAP_READERS];
+    unsigned long epoch;
+    pthread_mutex_t retireLock;
+    Retired *retired;
+    void (*releaseValue)(void *val);
+};
+
+///
+// checkedMalloc - mallocs a block, exiting if that fails
+///
+static void *checkedMalloc(size_t size)
+{
+    void *block = malloc(size);
+    if(block == NULL)
+    {
+        perror( "chunk map allocation failed" );
+        exit( 1 );
+    }
+    return block;
+}
+
+///
+// makeSlots - creates empty slots
+// @param capacity the number of slots
+// @return the slots
+///
+static MapSlots *makeSlots(unsigned long capacity)
+{
+    MapSlots *slots = (MapSlots *)checkedMalloc(sizeof(MapSlots));
+    slots->capacity = capacity;
+    slots->used = 0;
+    slots->ctrl = (uint64_t *)checkedMalloc(
+        capacity / MAP_GROUP * sizeof(uint64_t));
+    slots->slots = (ChunkTableSlot *)checkedMalloc(
+        capacity * sizeof(ChunkTableSlot));
+
+    for(unsigned long i = 0; i < capacity / MAP_GROUP; i++)
+    {
+        slots->ctrl[i] = GROUP_BYTES(CHUNK_CTRL_EMPTY);
+    }
+    return slots;
+}
+
+///
+// freeSlots - frees slots; the values in them are not freed
+// @param ptr the slots
+///
+static void freeSlots(void *ptr)
+{
+    MapSlots *slots = (MapSlots *)ptr;
+    free(slots->ctrl);
+    free(slots->slots);
+    free(slots);
+}
+
+///
+// groupMatch - finds the slots of a group whose metadata is a given byte
+// @param group the metadata word of the group
+// @param ctrl the metadata byte being looked for
+// @return a word with the top bit of byte i set if slot i may match; a byte
+//   above a true match may be set too, but the lowest set byte always
+//   matches, and the word is only zero if no slot does
+///
+static inline uint64_t groupMatch(uint64_t group, signed char ctrl)
+{
+    uint64_t bytes = group ^ GROUP_BYTES(ctrl);
+    return (bytes - GROUP_BYTES(1)) & ~bytes & GROUP_BYTES(0x80);
+}
+
+///
+// groupByte - gets the metadata byte of a slot of a group
+// @param group the metadata word of the group
+// @param i the slot
+///
+static inline signed char groupByte(uint64_t group, int i)
+{
+    return (signed char)(uint8_t)(group >> (8 * i));
+}
+
+///
+// lowestSlot - gets the slot of the lowest set byte of a non-zero match
+///
+static inline int lowestSlot(uint64_t match)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(match) / 8;
+#else
+    int slot = 0;
+    while(!(match & 0xFF))
+    {
+        match >>= 8;
+        slot++;
+    }
+    return slot;
+#endif
+}
+
+///
+// findSlot - finds the full slot holding (x, y) in a stripe's slots
+// @param slots the slots being searched
+// @param hash the hash of the coordinates
+// @param x, y the coordinates being looked for
+// @return the index of the slot, or -1 if (x, y) is not there
+///
+static long findSlot(const MapSlots *slots, uint64_t hash, int x, int y)
+{
+    signed char h2 = chunkCtrlOf(hash);
+    unsigned long groups = slots->capacity / MAP_GROUP;
+    unsigned long group = (unsigned long)hash & (groups - 1);
+
+    for(unsigned long probe = 1; probe <= groups; probe++)
+    {
+        uint64_t ctrl = __atomic_load_n(&slots->ctrl[group], __ATOMIC_ACQUIRE);
+        uint64_t match = groupMatch(ctrl, h2);
+
+        while(match != 0)
+        {
+            int i = lowestSlot(match);
+            unsigned long index = group * MAP_GROUP + i;
+
+            // Only a slot whose metadata really matches is sure to have its
+            // key filled in
+            if(groupByte(ctrl, i) == h2 && slots->slots[index].x == x &&
+                slots->slots[index].y == y)
+            {
+                return (long)index;
+            }
+            match &= match - 1;
+        }
+
+        // A key is always placed before the first empty slot on its probe
+        // sequence, so it cannot be any further along
+        if(groupMatch(ctrl, CHUNK_CTRL_EMPTY) != 0)
+        {
+            return -1;
+        }
+
+        group = (group + probe) & (groups - 1);
+    }
+
+    return -1;
+}
+
+///
+// setCtrl - publishes the metadata of a slot; the caller holds the lock of
+// the stripe, so no other writer changes the word in between
+// @param slots the slots of the stripe
+// @param index the slot
+// @param ctrl its new metadata byte
+///
+static void setCtrl(MapSlots *slots, unsigned long index, signed char ctrl)
+{
+    uint64_t *word = &slots->ctrl[index / MAP_GROUP];
+    int shift = 8 * (index % MAP_GROUP);
+    uint64_t group = __atomic_load_n(word, __ATOMIC_RELAXED);
+
+    group &= ~(0xFFull << shift);
+    group |= (uint64_t)(uint8_t)ctrl << shift;
+    __atomic_store_n(word, group, __ATOMIC_RELEASE);
+}
+
+///
+// insertSlot - fills in the first empty slot on the probe sequence of
+// (x, y) and publishes it; there always is one, since the slots are never
+// full
+// @param slots the slots of the stripe, locked by the caller
+// @param hash the hash of the coordinates
+// @param x, y the coordinates the value is stored under
+// @param val the value
+///
+static void insertSlot(MapSlots *slots, uint64_t hash, int x, int y,
+    void *val)
+{
+    unsigned long groups = slots->capacity / MAP_GROUP;
+    unsigned long group = (unsigned long)hash & (groups - 1);
+
+    for(unsigned long probe = 1; ; probe++)
+    {
+        uint64_t empty = groupMatch(
+            __atomic_load_n(&slots->ctrl[group], __ATOMIC_RELAXED),
+            CHUNK_CTRL_EMPTY);
+
+        if(empty != 0)
+        {
+            unsigned long index = group * MAP_GROUP + lowestSlot(empty);
+            ChunkTableSlot *slot = &slots->slots[index];
+
+            slot->x = x;
+            slot->y = y;
+            __atomic_store_n(&slot->val, val, __ATOMIC_RELAXED);
+            setCtrl(slots, index, chunkCtrlOf(hash));
+            slots->used += 1;
+            return;
+        }
+
+        group = (group + probe) & (groups - 1);
+    }
+}
+
+///
+// stripeOf - picks the stripe of a hash; the group is picked by the low bits
+// of the same hash and the metadata byte by the top ones, so this uses bits
+// in between
+///
+static MapStripe *stripeOf(ChunkMap map, uint64_t hash)
+{
+    return &map->stripes[(hash >> 32) % CHUNK_MAP_STRIPES];
+}
+
+///
+// retire - hands something unlinked from the map over to be freed once no
+// reader can be using it, then frees whatever already can be
+// @param map the map it was unlinked from
+// @param ptr the thing being retired
+// @param release the function that frees it
+///
+static void retire(ChunkMap map, void *ptr, void (*release)(void *ptr))
+{
+    Retired *retired = (Retired *)checkedMalloc(sizeof(Retired));
+    retired->ptr = ptr;
+    retired->release = release;
+
+    // Readers pinning from now on cannot reach it
+    retired->epoch = __atomic_fetch_add(&map->epoch, 1, __ATOMIC_SEQ_CST);
+
+    pthread_mutex_lock(&map->retireLock);
+    retired->next = map->retired;
+    map->retired = retired;
+    pthread_mutex_unlock(&map->retireLock);
+
+    chunkMapCollect(map);
+}
+
+///
+// makeChunkMap - creates a new empty map
+// @param releaseValue called on a value once it has been replaced or removed
+//   and no reader can still be using it (may be NULL)
+// @return a new ChunkMap pointer
+///
+ChunkMap makeChunkMap(void (*releaseValue)(void *val))
+{
+    ChunkMap map = (ChunkMap)checkedMalloc(sizeof(struct chunkMap));
+
+    for(int i = 0; i < CHUNK_MAP_STRIPES; i++)
+    {
+        pthread_mutex_init(&map->stripes[i].lock, NULL);
+        map->stripes[i].slots = makeSlots(STRIPE_CAPACITY);
+        map->stripes[i].size = 0;
+    }
+
+    for(int i = 0; i < CHUNK_MAP_READERS; i++)
+    {
+        map->readers[i].epoch = 0;
+    }
+
+    map->epoch = 1;
+    pthread_mutex_init(&map->retireLock, NULL);
+    map->retired = NULL;
+    map->releaseValue = releaseValue;
+
+    return map;
+}
+
+///
+// destroyChunkMap - deallocates all the memory associated with a map; no
+// thread may be using it. Values still in the map are not released.
+// @param map the map being destroyed
+///
+void destroyChunkMap(ChunkMap map)
+{
+    for(int i = 0; i < CHUNK_MAP_STRIPES; i++)
+    {
+        freeSlots(map->stripes[i].slots);
+        pthread_mutex_destroy(&map->stripes[i].lock);
+    }
+
+    // Nobody is reading any more, so everything retired can go
+    Retired *retired = map->retired;
+    while(retired != NULL)
+    {
+        Retired *next = retired->next;
+        retired->release(retired->ptr);
+        free(retired);
+        retired = next;
+    }
+
+    pthread_mutex_destroy(&map->retireLock);
+    free(map);
+}
+
+///
+// chunkMapPin - starts a read of a map; nothing looked up is freed before the
+// matching chunkMapUnpin()
+// @param map the map being read
+// @return the pin, to be handed to chunkMapUnpin()
+///
+int chunkMapPin(ChunkMap map)
+{
+    for(;;)
+    {
+        for(int i = 0; i < CHUNK_MAP_READERS; i++)
+        {
+            unsigned long unpinned = 0;
+            unsigned long epoch = __atomic_load_n(&map->epoch,
+                __ATOMIC_SEQ_CST);
+
+            if(__atomic_compare_exchange_n(&map->readers[i].epoch, &unpinned,
+                epoch, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+            {
+                // Pairs with the fence in chunkMapCollect(): either the
+                // collector sees this slot, or this reader sees the map
+                // with everything the collector frees already unlinked
+                __atomic_thread_fence(__ATOMIC_SEQ_CST);
+                return i;
+            }
+        }
+
+        // Every slot is taken; wait for a reader to finish
+        sched_yield();
+    }
+}
+
+///
+// chunkMapUnpin - ends a read of a map started by chunkMapPin()
+// @param map the map being read
+// @param pin the pin returned by chunkMapPin()
+///
+void chunkMapUnpin(ChunkMap map, int pin)
+{
+    __atomic_store_n(&map->readers[pin].epoch, 0, __ATOMIC_RELEASE);
+}
+
+///
+// chunkMapGet - grabs the value at (x, y) from a map; the caller must have
+// the map pinned, and may only use the value until it unpins it
+// @param map the map we are searching through
+// @param x, y the coordinates of the value we are getting
+// @return the value at (x, y), or if no value was found NULL
+///
+void *chunkMapGet(ChunkMap map, int x, int y)
+{
+    uint64_t hash = hashChunkCoord(x, y);
+    MapStripe *stripe = stripeOf(map, hash);
+    MapSlots *slots = __atomic_load_n(&stripe->slots, __ATOMIC_ACQUIRE);
+    long found = findSlot(slots, hash, x, y);
+
+    return found >= 0 ?
+        __atomic_load_n(&slots->slots[found].val, __ATOMIC_ACQUIRE) : NULL;
+}
+
+///
+// rehashStripe - copies the values of a stripe into new slots and publishes
+// them; the stripe doubles in size if it is filling up, or else just sheds
+// its deleted slots. The slots are copied rather than moved, since readers
+// may still be probing the old ones.
+// @param stripe the stripe, locked by the caller
+// @return the old slots, to be retired once the stripe is unlocked
+///
+static MapSlots *rehashStripe(MapStripe *stripe)
+{
+    MapSlots *old = stripe->slots;
+    unsigned long capacity = old->capacity;
+
+    if((stripe->size + 1) * 16 > capacity * MAX_LOAD_EIGHTHS)
+    {
+        capacity *= 2;
+    }
+
+    MapSlots *slots = makeSlots(capacity);
+
+    for(unsigned long i = 0; i < old->capacity; i++)
+    {
+        if(groupByte(old->ctrl[i / MAP_GROUP], i % MAP_GROUP) >= 0)
+        {
+            const ChunkTableSlot *slot = &old->slots[i];
+            insertSlot(slots, hashChunkCoord(slot->x, slot->y), slot->x,
+                slot->y, slot->val);
+        }
+    }
+
+    __atomic_store_n(&stripe->slots, slots, __ATOMIC_RELEASE);
+    return old;
+}
+
+///
+// chunkMapPut - puts a value into a map at (x, y); a value already there is
+// replaced and released once no reader can be using it
+// @param map the map we are updating
+// @param x, y the coordinates the value is stored under
+// @param val the value being put into the map
+///
+void chunkMapPut(ChunkMap map, int x, int y, void *val)
+{
+    uint64_t hash = hashChunkCoord(x, y);
+    MapStripe *stripe = stripeOf(map, hash);
+    void *replaced = NULL;
+    MapSlots *outgrown = NULL;
+
+    pthread_mutex_lock(&stripe->lock);
+
+    MapSlots *slots = stripe->slots;
+    long found = findSlot(slots, hash, x, y);
+
+    if(found >= 0)
+    {
+        // If we find the key we are currently trying to insert, swap in the
+        // new val
+        replaced = slots->slots[found].val;
+        __atomic_store_n(&slots->slots[found].val, val, __ATOMIC_RELEASE);
+    }
+    else
+    {
+        // Keep enough slots empty that probe sequences stay short
+        if((slots->used + 1) * 8 > slots->capacity * MAX_LOAD_EIGHTHS)
+        {
+            outgrown = rehashStripe(stripe);
+            slots = stripe->slots;
+        }
+
+        insertSlot(slots, hash, x, y, val);
+        stripe->size += 1;
+    }
+
+    pthread_mutex_unlock(&stripe->lock);
+
+    // Nothing is freed with the stripe locked
+    if(outgrown != NULL)
+    {
+        retire(map, outgrown, freeSlots);
+    }
+
+    if(replaced != NULL && replaced != val && map->releaseValue != NULL)
+    {
+        retire(map, replaced, map->releaseValue);
+    }
+}
+
+///
+// chunkMapRemove - takes the value at (x, y) out of a map; it is released
+// once no reader can be using it
+// @param map the map we are updating
+// @param x, y the coordinates of the value being removed
+// @return true if there was a value to remove, otherwise false
+///
+bool chunkMapRemove(ChunkMap map, int x, int y)
+{
+    uint64_t hash = hashChunkCoord(x, y);
+    MapStripe *stripe = stripeOf(map, hash);
+
+    pthread_mutex_lock(&stripe->lock);
+
+    MapSlots *slots = stripe->slots;
+    long found = findSlot(slots, hash, x, y);
+
+    if(found < 0)
+    {
+        pthread_mutex_unlock(&stripe->lock);
+        return false;
+    }
+
+    // The slot may sit in the middle of another key's probe sequence, so it
+    // is marked deleted rather than empty; a reader that already matched it
+    // finds no value
+    void *val = slots->slots[found].val;
+    setCtrl(slots, (unsigned long)found, CHUNK_CTRL_DELETED);
+    __atomic_store_n(&slots->slots[found].val, NULL, __ATOMIC_RELEASE);
+    stripe->size -= 1;
+
+    pthread_mutex_unlock(&stripe->lock);
+
+    if(val != NULL && map->releaseValue != NULL)
+    {
+        retire(map, val, map->releaseValue);
+    }
+    return true;
+}
+
+///
+// chunkMapCollect - frees whatever has been removed from a map and is no
+// longer pinned by any reader; writers do this as they go, so this is only
+// needed to clean up after the last write
+// @param map the map being cleaned up
+///
+void chunkMapCollect(ChunkMap map)
+{
+    // Pairs with the fence in chunkMapPin()
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    // Everything retired so far has an epoch below the current one; the
+    // oldest pinned reader may hold anything retired at or after its epoch
+    unsigned long oldest = __atomic_load_n(&map->epoch, __ATOMIC_SEQ_CST);
+    for(int i = 0; i < CHUNK_MAP_READERS; i++)
+    {
+        unsigned long epoch = __atomic_load_n(&map->readers[i].epoch,
+            __ATOMIC_SEQ_CST);
+        if(epoch != 0 && epoch < oldest)
+        {
+            oldest = epoch;
+        }
+    }
+
+    // Take what can be freed off the list, and free it outside of the lock
+    Retired *done = NULL;
+    pthread_mutex_lock(&map->retireLock);
+    Retired **link = &map->retired;
+    while(*link != NULL)
+    {
+        Retired *retired = *link;
+        if(retired->epoch < oldest)
+        {
+            *link = retired->next;
+            retired->next = done;
+            done = retired;
+        }
+        else
+        {
+            link = &retired->next;
+        }
+    }
+    pthread_mutex_unlock(&map->retireLock);
+
+    while(done != NULL)
+    {
+        Retired *next = done->next;
+        done->release(done->ptr);
+        free(done);
+        done = next;
+    }
+}
@@ -0,0 +1,357 @@
+///
+// chunkTable.c a C/C++ implementation for a hash table keyed by the integer
+// coordinates of a chunk
+//
+// Every slot has a metadata byte in ctrl: EMPTY, DELETED, or the top 7 bits
+// of the hash of its key (h2). The low bits of the hash (h1) pick the group of
+// CHUNK_TABLE_GROUP slots a key starts probing from. A whole group is
+// checked at once by comparing its metadata bytes to h2, so a key is only
+// compared with the few slots whose h2 matches, and a lookup usually ends in
+// the first group. Groups are probed in a triangular sequence, which visits
+// every group of a power of two sized table.
+//
+// Author: T. Wilgenbusch
+///
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "chunkTable.h"
+
+/// The fraction of the slots that may be full or deleted, in eighths
+#define MAX_LOAD_EIGHTHS 7
+
+///
+// groupMatch - finds the slots of a group whose metadata is a given byte
+// @param group the metadata of the first slot of the group
+// @param ctrl the metadata byte being looked for
+// @return a mask with bit i set if slot i of the group matches
+///
+static inline unsigned int groupMatch(const signed char *group,
+    signed char ctrl)
+{
+#if defined(__SSE2__)
+    __m128i bytes = _mm_loadu_si128((const __m128i *)group);
+    return (unsigned int)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(bytes, _mm_set1_epi8(ctrl)));
+#else
+    unsigned int mask = 0;
+    for(int i = 0; i < CHUNK_TABLE_GROUP; i++)
+    {
+        mask |= (unsigned int)(group[i] == ctrl) << i;
+    }
+    return mask;
+#endif
+}
+
+///
+// groupMatchFree - finds the slots of a group that are empty or deleted
+// @param group the metadata of the first slot of the group
+// @return a mask with bit i set if slot i of the group is free
+///
+static inline unsigned int groupMatchFree(const signed char *group)
+{
+#if defined(__SSE2__)
+    // Free slots are the only ones with their top bit set
+    __m128i bytes = _mm_loadu_si128((const __m128i *)group);
+    return (unsigned int)_mm_movemask_epi8(bytes);
+#else
+    unsigned int mask = 0;
+    for(int i = 0; i < CHUNK_TABLE_GROUP; i++)
+    {
+        mask |= (unsigned int)(group[i] < 0) << i;
+    }
+    return mask;
+#endif
+}
+
+///
+// lowestBit - gets the index of the lowest set bit of a non-zero mask
+///
+static inline int lowestBit(unsigned int mask)
+{
+#if defined(__GNUC__)
+    return __builtin_ctz(mask);
+#else
+    int bit = 0;
+    while(!(mask & 1u))
+    {
+        mask >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+///
+// findSlot - finds the slot holding (x, y) in a table
+// @param table the table being searched
+// @param x, y the coordinates being looked for
+// @return the index of the slot, or -1 if (x, y) is not in the table
+///
+static long findSlot(ChunkTable table, int x, int y)
+{
+    uint64_t hash = hashChunkCoord(x, y);
+    signed char h2 = chunkCtrlOf(hash);
+    unsigned long groups = table->capacity / CHUNK_TABLE_GROUP;
+    unsigned long group = (unsigned long)hash & (groups - 1);
+
+    for(unsigned long probe = 1; probe <= groups; probe++)
+    {
+        const signed char *ctrl = table->ctrl + group * CHUNK_TABLE_GROUP;
+        unsigned int match = groupMatch(ctrl, h2);
+
+        while(match != 0)
+        {
+            unsigned long index = group * CHUNK_TABLE_GROUP + lowestBit(match);
+            if(table->slots[index].x == x && table->slots[index].y == y)
+            {
+                return (long)index;
+            }
+            match &= match - 1;
+        }
+
+        // A key is always placed before the first empty slot on its probe
+        // sequence, so it cannot be any further along
+        if(groupMatch(ctrl, CHUNK_CTRL_EMPTY) != 0)
+        {
+            return -1;
+        }
+
+        group = (group + probe) & (groups - 1);
+    }
+
+    return -1;
+}
+
+///
+// findFreeSlot - finds the first empty or deleted slot on the probe sequence
+// of (x, y); there always is one, since the table is never full
+// @param table the table being searched
+// @param hash the hash of the coordinates
+// @return the index of the slot
+///
+static unsigned long findFreeSlot(ChunkTable table, uint64_t hash)
+{
+    unsigned long groups = table->capacity / CHUNK_TABLE_GROUP;
+    unsigned long group = (unsigned long)hash & (groups - 1);
+
+    for(unsigned long probe = 1; ; probe++)
+    {
+        unsigned int available = groupMatchFree(
+            table->ctrl + group * CHUNK_TABLE_GROUP);
+
+        if(available != 0)
+        {
+            return group * CHUNK_TABLE_GROUP + lowestBit(available);
+        }
+
+        group = (group + probe) & (groups - 1);
+    }
+}
+
+///
+// allocateSlots - gives a table new, empty slots
+// @param table the table being set up
+// @param capacity the number of slots
+///
+static void allocateSlots(ChunkTable table, unsigned long capacity)
+{
+    table->capacity = capacity;
+    table->deleted = 0;
+    table->ctrl = (signed char *)malloc(capacity);
+    table->slots = (ChunkTableSlot *)malloc(
+        capacity * sizeof(ChunkTableSlot));
+    if(table->ctrl == NULL || table->slots == NULL)
+    {
+        perror( "chunk table allocation failed" );
+        exit( 1 );
+    }
+
+    memset(table->ctrl, CHUNK_CTRL_EMPTY, capacity);
+}
+
+///
+// rehash - moves the values of a table into new slots; the table doubles in
+// size if it is filling up, or else just sheds its deleted slots
+// @param table the table being rehashed
+///
+static void rehash(ChunkTable table)
+{
+    signed char *oldCtrl = table->ctrl;
+    ChunkTableSlot *oldSlots = table->slots;
+    unsigned long oldCapacity = table->capacity;
+    unsigned long capacity = oldCapacity;
+
+    if((table->size + 1) * 16 > oldCapacity * MAX_LOAD_EIGHTHS)
+    {
+        capacity *= 2;
+    }
+
+    allocateSlots(table, capacity);
+
+    for(unsigned long i = 0; i < oldCapacity; i++)
+    {
+        if(oldCtrl[i] >= 0)
+        {
+            const ChunkTableSlot *slot = &oldSlots[i];
+            uint64_t hash = hashChunkCoord(slot->x, slot->y);
+            unsigned long index = findFreeSlot(table, hash);
+
+            table->ctrl[index] = chunkCtrlOf(hash);
+            table->slots[index] = *slot;
+        }
+    }
+
+    free(oldCtrl);
+    free(oldSlots);
+}
+
+///
+// makeChunkTable - creates a new empty table
+// @param initialSize the number of values the table should hold before it
+//   has to grow
+// @return a new ChunkTable pointer
+///
+ChunkTable makeChunkTable(unsigned long initialSize)
+{
+    ChunkTable table = (ChunkTable)malloc(sizeof(struct chunkTable));
+    unsigned long capacity = CHUNK_TABLE_GROUP;
+
+    if(table == NULL)
+    {
+        perror( "chunk table allocation failed" );
+        exit( 1 );
+    }
+
+    while(capacity * MAX_LOAD_EIGHTHS / 8 <= initialSize)
+    {
+        capacity *= 2;
+    }
+
+    table->size = 0;
+    allocateSlots(table, capacity);
+    return table;
+}
+
+///
+// destroyChunkTable - deallocates all the memory associated with a table;
+// the values are not freed
+// @param table the table being destroyed
+///
+void destroyChunkTable(ChunkTable table)
+{
+    free(table->ctrl);
+    free(table->slots);
+    free(table);
+}
+
+///
+// chunkTableContains - determines if there is a value at (x, y) in a table
+// @param table - the table we are searching through
+// @param x, y - the coordinates we are looking for
+// @return true if (x, y) is already in table, otherwise false
+///
+bool chunkTableContains(ChunkTable table, int x, int y)
+{
+    return findSlot(table, x, y) >= 0;
+}
+
+///
+// chunkTablePut - puts a value into a table at (x, y), replacing any value
+// already there; the table grows in place, so the pointer stays valid
+// @param table the table we are updating
+// @param x, y the coordinates the value is stored under
+// @param val the value being put into the table
+///
+void chunkTablePut(ChunkTable table, int x, int y, void *val)
+{
+    long found = findSlot(table, x, y);
+
+    // If we find the key we are currently trying to insert, update its val
+    if(found >= 0)
+    {
+        table->slots[found].val = val;
+        return;
+    }
+
+    // Keep enough slots empty that probe sequences stay short
+    if((table->size + table->deleted + 1) * 8 >
+        table->capacity * MAX_LOAD_EIGHTHS)
+    {
+        rehash(table);
+    }
+
+    uint64_t hash = hashChunkCoord(x, y);
+    unsigned long index = findFreeSlot(table, hash);
+
+    if(table->ctrl[index] == CHUNK_CTRL_DELETED)
+    {
+        table->deleted -= 1;
+    }
+
+    table->ctrl[index] = chunkCtrlOf(hash);
+    table->slots[index].x = x;
+    table->slots[index].y = y;
+    table->slots[index].val = val;
+    table->size += 1;
+}
+
+///
+// chunkTableGet - grabs the value at (x, y) from a table
+// @param table the table we are searching through
+// @param x, y the coordinates of the value we are getting
+// @return the value at (x, y), or if no value was found NULL
+///
+void *chunkTableGet(ChunkTable table, int x, int y)
+{
+    long found = findSlot(table, x, y);
+    return found >= 0 ? table->slots[found].val : NULL;
+}
+
+///
+// chunkTableRemove - takes the value at (x, y) out of a table
+// @param table the table we are updating
+// @param x, y the coordinates of the value being removed
+// @return true if there was a value to remove, otherwise false
+///
+bool chunkTableRemove(ChunkTable table, int x, int y)
+{
+    long found = findSlot(table, x, y);
+
+    if(found < 0)
+    {
+        return false;
+    }
+
+    // The slot may sit in the middle of another key's probe sequence, so it
+    // is marked deleted rather than empty
+    table->ctrl[found] = CHUNK_CTRL_DELETED;
+    table->size -= 1;
+    table->deleted += 1;
+    return true;
+}
+
+///
+// printChunkTable - prints the current table to std-out (used for debugging)
+// @param table the table being printed
+///
+void printChunkTable(ChunkTable table)
+{
+    for(unsigned long i = 0; i < table->capacity; i++)
+    {
+        // Ignore spots that are not filled
+        if(table->ctrl[i] >= 0)
+        {
+            printf("[%lu] (%d, %d) -> %p\n", i, table->slots[i].x,
+                table->slots[i].y, table->slots[i].val);
+        }
+    }
+}
@@ -0,0 +1,298 @@
+///
+// hashBench.c a C/C++ implementation for timing the hash table lookups
+//
+// Every table holds the even numbers below twice its size, and is looked up
+// with the same pseudo random keys, half of which are odd and so miss, by a
+// loop of get() calls and by getMany(), and the same keys are looked up in
+// a HASH_TABLE_TYPED table and in a ChunkTable holding the same entries, the
+// latter with each key split into chunk coordinates. All four must find the
+// same values. Half of the entries are then removed from the ChunkTable,
+// which must still find the rest.
+//
+// Each variant is timed BENCH_PASSES times and its median pass is printed.
+// The order the variants run in rotates from pass to pass, so none of them
+// always runs on caches warmed by another.
+//
+// Author: T. Wilgenbusch
+///
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "hashTableADT.h"
+#include "hashTableTyped.h"
+#include "chunkTable.h"
+#include "hashBench.h"
+
+/// The number of lookups timed on every table
+#define BENCH_LOOKUPS 2000000
+
+/// The number of times each variant is timed; odd, so there is a middle one
+#define BENCH_PASSES 5
+
+/// The variants timed, in the order they run in the first pass
+#define BENCH_LOOP 0
+#define BENCH_BATCH 1
+#define BENCH_TYPED 2
+#define BENCH_CHUNK 3
+#define BENCH_VARIANTS 4
+
+/// The width of the rows of chunk coordinates keys are split into
+#define BENCH_ROW 2048
+
+/// The chunk coordinates of a key
+#define BENCH_X(key) ((int)((key) % BENCH_ROW))
+#define BENCH_Y(key) ((int)((key) / BENCH_ROW))
+
+/// The sizes of the tables timed
+static const unsigned long benchSizes[] = { 1000, 100000, 1000000, 4000000 };
+
+///
+// hashKey - hashes a key of the benchmark tables
+// @param key the unsigned long being hashed
+// @param capacity the number of buckets
+// @return the bucket of the key
+///
+static unsigned long hashKey(const void *key, const unsigned long capacity)
+{
+    unsigned long h = *(const unsigned long *)key * 0x9E3779B97F4A7C15ull;
+    return (h ^ (h >> 29)) % capacity;
+}
+
+///
+// equalKey - compares two keys of the benchmark tables
+// @param key1, key2 the unsigned longs being compared
+// @return true if they are equal
+///
+static bool equalKey(const void *key1, const void *key2)
+{
+    return *(const unsigned long *)key1 == *(const unsigned long *)key2;
+}
+
+///
+// hashTypedKey, equalTypedKey - hash and compare the keys of the typed 
+// benchmark table, mixing keys the same way as hashKey()
+///
+static inline uint64_t hashTypedKey(unsigned long key)
+{
+    uint64_t h = key * 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 29);
+}
+
+static inline bool equalTypedKey(unsigned long key1, unsigned long key2)
+{
+    return key1 == key2;
+}
+
+/// The typed table timed next to hashTableADT, holding each key as its own 
+/// value
+HASH_TABLE_TYPED(BenchTable, unsigned long, unsigned long, hashTypedKey, 
+    equalTypedKey)
+
+///
+// printKey - prints a key of the benchmark tables (used by printTable())
+// @param key the unsigned long being printed
+// @param val its value
+///
+static void printKey(const void *key, const void *val)
+{
+    (void)val;
+    printf("%lu", *(const unsigned long *)key);
+}
+
+///
+// nowSeconds - reads the monotonic clock
+// @return the time in seconds
+///
+static double nowSeconds()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+///
+// benchMalloc - allocates memory for the benchmark, exiting if it can not
+// @param size the number of bytes
+// @return the memory
+///
+static void *benchMalloc(size_t size)
+{
+    void *memory = malloc(size);
+    if(memory == NULL)
+    {
+        perror( "benchmark allocation failed" );
+        exit( 1 );
+    }
+    return memory;
+}
+
+///
+// compareTimes - orders two times for qsort()
+// @param a, b the doubles being compared
+// @return negative, zero or positive as a is less than, equal to or greater
+//   than b
+///
+static int compareTimes(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+///
+// medianTime - finds the median of the times of a variant's passes
+// @param times the BENCH_PASSES times; they are sorted in place
+// @return the median time
+///
+static double medianTime(double *times)
+{
+    qsort(times, BENCH_PASSES, sizeof(double), compareTimes);
+    return times[BENCH_PASSES / 2];
+}
+
+///
+// hashBench - times a loop of get() calls against getMany() and against a 
+// typed table on tables from a few thousand up to a few million entries, 
+// and prints the results
+///
+void hashBench()
+{
+    unsigned long *lookupKeys = (unsigned long *)benchMalloc(
+        BENCH_LOOKUPS * sizeof(unsigned long));
+    void **lookups = (void **)benchMalloc(BENCH_LOOKUPS * sizeof(void *));
+    void **looped = (void **)benchMalloc(BENCH_LOOKUPS * sizeof(void *));
+    void **batched = (void **)benchMalloc(BENCH_LOOKUPS * sizeof(void *));
+    unsigned long **typedVals = (unsigned long **)benchMalloc(
+        BENCH_LOOKUPS * sizeof(unsigned long *));
+    void **chunkVals = (void **)benchMalloc(BENCH_LOOKUPS * sizeof(void *));
+
+    printf("%d lookups, about half missing; median ns per lookup of %d "
+        "passes\n", BENCH_LOOKUPS, BENCH_PASSES);
+    printf("%10s %10s %10s %10s %10s\n", "entries", "get()", "getMany()", 
+        "typed", "chunkTable");
+
+    for(unsigned long s = 0; s < sizeof(benchSizes) / sizeof(*benchSizes);
+        s++)
+    {
+        unsigned long size = benchSizes[s];
+        unsigned long *keys = (unsigned long *)benchMalloc(
+            size * sizeof(unsigned long));
+
+        HashTableADT table = create(16, hashKey, equalKey, printKey);
+        BenchTable typed;
+        BenchTableCreate(&typed, 16);
+        ChunkTable chunkTable = makeChunkTable(16);
+        for(unsigned long i = 0; i < size; i++)
+        {
+            keys[i] = 2 * i;
+            put(&table, &keys[i], &keys[i]);
+            BenchTablePut(&typed, keys[i], keys[i]);
+            chunkTablePut(chunkTable, BENCH_X(keys[i]), BENCH_Y(keys[i]), 
+                &keys[i]);
+        }
+
+        // A fixed linear congruential generator, so every run looks up the
+        // same keys
+        unsigned long long seed = 1;
+        for(unsigned long i = 0; i < BENCH_LOOKUPS; i++)
+        {
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+            lookupKeys[i] = (unsigned long)(seed >> 33) % (2 * size);
+            lookups[i] = &lookupKeys[i];
+        }
+
+        double times[BENCH_VARIANTS][BENCH_PASSES];
+        for(int pass = 0; pass < BENCH_PASSES; pass++)
+        {
+            for(int v = 0; v < BENCH_VARIANTS; v++)
+            {
+                int variant = (pass + v) % BENCH_VARIANTS;
+                double start = nowSeconds();
+
+                if(variant == BENCH_LOOP)
+                {
+                    for(unsigned long i = 0; i < BENCH_LOOKUPS; i++)
+                    {
+                        looped[i] = get(table, lookups[i]);
+                    }
+                }
+                else if(variant == BENCH_BATCH)
+                {
+                    getMany(table, lookups, BENCH_LOOKUPS, batched);
+                }
+                else if(variant == BENCH_TYPED)
+                {
+                    for(unsigned long i = 0; i < BENCH_LOOKUPS; i++)
+                    {
+                        typedVals[i] = BenchTableGet(&typed, lookupKeys[i]);
+                    }
+                }
+                else
+                {
+                    for(unsigned long i = 0; i < BENCH_LOOKUPS; i++)
+                    {
+                        chunkVals[i] = chunkTableGet(chunkTable, 
+                            BENCH_X(lookupKeys[i]), BENCH_Y(lookupKeys[i]));
+                    }
+                }
+
+                times[variant][pass] = nowSeconds() - start;
+            }
+        }
+
+        for(unsigned long i = 0; i < BENCH_LOOKUPS; i++)
+        {
+            bool found = looped[i] != NULL;
+            if(looped[i] != batched[i] || looped[i] != chunkVals[i] ||
+                found != (typedVals[i] != NULL) ||
+                (found && *typedVals[i] != lookupKeys[i]))
+            {
+                fprintf(stderr, "the lookups disagree on %lu\n",
+                    lookupKeys[i]);
+                exit( 1 );
+            }
+        }
+
+        // Removing the first half of the entries leaves tombstones that 
+        // lookups of the second half must probe past
+        for(unsigned long i = 0; i < size / 2; i++)
+        {
+            chunkTableRemove(chunkTable, BENCH_X(keys[i]), BENCH_Y(keys[i]));
+        }
+
+        for(unsigned long i = 0; i < BENCH_LOOKUPS; i++)
+        {
+            bool kept = looped[i] != NULL && lookupKeys[i] >= 2 * (size / 2);
+            if(chunkTableContains(chunkTable, BENCH_X(lookupKeys[i]), 
+                BENCH_Y(lookupKeys[i])) != kept)
+            {
+                fprintf(stderr, "the chunk table is wrong about %lu after "
+                    "removals\n", lookupKeys[i]);
+                exit( 1 );
+            }
+        }
+
+        printf("%10lu %10.1f %10.1f %10.1f %10.1f\n", size, 
+            medianTime(times[BENCH_LOOP]) * 1e9 / BENCH_LOOKUPS, 
+            medianTime(times[BENCH_BATCH]) * 1e9 / BENCH_LOOKUPS,
+            medianTime(times[BENCH_TYPED]) * 1e9 / BENCH_LOOKUPS,
+            medianTime(times[BENCH_CHUNK]) * 1e9 / BENCH_LOOKUPS);
+
+        destroy(table);
+        BenchTableDestroy(&typed);
+        destroyChunkTable(chunkTable);
+        free(keys);
+    }
+
+    free(lookupKeys);
+    free(lookups);
+    free(looped);
+    free(batched);
+    free(typedVals);
+    free(chunkVals);
+}
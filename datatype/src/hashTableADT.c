@@ -4,30 +4,125 @@
 // Author: T. Wilgenbusch
 ///
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
+#include <time.h>
 
 #include "hashTableADT.h"
 
 /// The load factor used when the table needs to be resized
 #define LOAD_FACTOR .75
 
+/// The number of entries in the first slab of a table, and the most in any 
+/// slab
+#define FIRST_SLAB_ENTRIES 32
+#define MAX_SLAB_ENTRIES 4096
+
+/// The number of buckets of the old table moved over by each put() while 
+/// the table grows; a table grows to over twice its capacity, so this many 
+/// is always done well before it has to grow again
+#define MIGRATE_BUCKETS 4
+
+/// The number of keys getMany() and containsMany() hash and prefetch ahead 
+/// of walking their chains
+#define BATCH_LOOKUPS 16
+
+/// Starts loading the cache line at an address; does nothing on compilers 
+/// without __builtin_prefetch
+#if defined(__GNUC__)
+#define PREFETCH(address) __builtin_prefetch(address)
+#else
+#define PREFETCH(address) ((void)(address))
+#endif
+
+/// Adds to one of the counters of a table; does nothing unless compiled with 
+/// HASH_TABLE_STATS defined
+#ifdef HASH_TABLE_STATS
+#define COUNT(hTable, field, n) ((hTable)->counters.field += (n))
+#else
+#define COUNT(hTable, field, n) ((void)(hTable), (void)(n))
+#endif
+
+#ifdef HASH_TABLE_STATS
+///
+// nowNanos - reads the monotonic clock, for timing how long resizes take
+// @return the time in nanoseconds
 ///
-// makeEntry - creates an entry pointer
+static unsigned long long nowNanos()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+#endif
+
+///
+// makeEntry - creates an entry pointer, taking it from the table's newest 
+//              slab; a new slab is only allocated once that one runs out, and 
+//              each is twice the size of the last (up to MAX_SLAB_ENTRIES)
+// @param hTable the table the entry belongs to
 // @param key the key for this entry
 // @param val the value for this entry
 // @return a pointer to an Entry struct
 ///
-static Entry *makeEntry(void *key, void*val)
+static Entry *makeEntry(HashTableADT hTable, void *key, void*val)
 {
-    Entry *entry = (Entry *)malloc(sizeof(Entry));
+    EntrySlab *slab = hTable->slabs;
+
+    if(slab == NULL || hTable->slabUsed == slab->count)
+    {
+        unsigned long count = FIRST_SLAB_ENTRIES;
+        if(slab != NULL)
+        {
+            count = slab->count < MAX_SLAB_ENTRIES ? slab->count * 2 
+                                                   : MAX_SLAB_ENTRIES;
+        }
+
+        // The entries follow the slab in the same block
+        EntrySlab *newSlab = (EntrySlab *)malloc(
+            sizeof(EntrySlab) + count * sizeof(Entry));
+        if(newSlab == NULL)
+        {
+            perror( "hash table allocation failed" );
+            exit( 1 );
+        }
+
+        newSlab->next = slab;
+        newSlab->count = count;
+        newSlab->entries = (Entry *)(newSlab + 1);
+        hTable->slabs = slab = newSlab;
+        hTable->slabUsed = 0;
+    }
+
+    Entry *entry = &slab->entries[hTable->slabUsed++];
     entry->next = NULL;
     entry->key = key;
     entry->val = val;
     return entry;
 }
 
+///
+// makeBuckets - creates an array of empty buckets; calloc() hands back 
+//              zeroed pages without touching them, so even a big table 
+//              costs little to make
+// @param capacity the number of buckets
+// @return the buckets, all NULL
+///
+static Entry **makeBuckets(unsigned long capacity)
+{
+    Entry **buckets = (Entry **)calloc(capacity, sizeof(Entry *));
+    if(buckets == NULL)
+    {
+        perror( "hash table allocation failed" );
+        exit( 1 );
+    }
+    return buckets;
+}
+
 ///
 // create - creates a new empty hash table
 // @param initialCapacity the hash tables initial capacity
@@ -52,188 +147,315 @@ HashTableADT create( unsigned long initialCapacity,
     hTable->equal = equal;
 
 
-    // Create a pointer to an Entry **, allocating enough space for the 
-    // initialCapacity of Entry * and set all of those pointers to NULL;
-    hTable->table = (Entry **)malloc(sizeof(Entry *) * initialCapacity);
-    for(unsigned long i = 0; i < initialCapacity; i++)
-    {
-        hTable->table[i] = NULL;
-    }
+    hTable->table = makeBuckets(initialCapacity);
+    hTable->oldTable = NULL;
+    hTable->oldCapacity = 0;
+    hTable->migrated = 0;
+    hTable->slabs = NULL;
+    hTable->slabUsed = 0;
+    hTable->resizes = 0;
+#ifdef HASH_TABLE_STATS
+    memset(&hTable->counters, 0, sizeof(HashTableCounters));
+#endif
 
     return hTable;
 }
 
 ///
-// freeChain - helper function used by destroy() and resize() to deallocate a 
-//              chain of entries in a hash table
-// @param chain - the beginning of a chain of entries to be removed
+// destroy - deallocates all the memory associated with a has table; the 
+//              entries are freed a slab at a time, so no chain is walked
+// @param hTable the hash table being destroyed
 ///
-void freeChain(Entry *chain)
+void destroy(HashTableADT hTable)
 {
-    // We've reached the last entry in the chain free it
-    if(chain != NULL && chain->next == NULL)
+    EntrySlab *slab = hTable->slabs;
+    while(slab != NULL)
     {
-        free(chain);
-        return;
+        EntrySlab *next = slab->next;
+        free(slab);
+        slab = next;
     }
 
-    // Recurse through chain until we reach the last element, then free the 
-    // elements in reverse order
-    freeChain(chain->next);
-
-    // Free the current entry
-    if(chain != NULL)
+    if(hTable->oldTable != NULL)
     {
-        free(chain);
+        free(hTable->oldTable);
     }
+
+    free(hTable->table);
+    free(hTable);
 }
 
 ///
-// destroy - deallocates all the memory associated with a has table
-// @param hTable the hash table being destroyed
+// searchChain - walks a chain of entries looking for a key
+// @param hTable - the hash table the chain is in
+// @param key - the key we are looking for
+// @param entry - the first entry of the chain
+// @param probes - counts the keys compared
+// @return the entry, or NULL if key is not in the chain
 ///
-void destroy(HashTableADT hTable)
+static Entry *searchChain(HashTableADT hTable, void *key, Entry *entry, 
+    unsigned long *probes)
 {
-    for(unsigned long i = 0; i < hTable->capacity; i++)
+    while(entry != NULL)
     {
-        // Ignore the the NULL entries in the hash table
-        if(hTable->table[i] != NULL)
+        *probes += 1;
+        if(hTable->equal(key, entry->key))
         {
-            // Free the entry
-            freeChain(hTable->table[i]);
+            return entry;
         }
+        entry = entry->next;
     }
 
-    free(hTable->table);
-    free(hTable);
+    return NULL;
 }
 
 ///
-// contains - determines if a key is in a hash table
+// countLookup - counts a finished lookup; does nothing unless compiled with 
+//              HASH_TABLE_STATS defined
+// @param hTable - the hash table searched
+// @param entry - the entry found, or NULL
+// @param probes - the keys compared
+///
+static void countLookup(HashTableADT hTable, Entry *entry, 
+    unsigned long probes)
+{
+    COUNT(hTable, lookups, 1);
+    if(entry != NULL)
+    {
+        COUNT(hTable, hits, 1);
+        COUNT(hTable, hitProbes, probes);
+    }
+    else
+    {
+        COUNT(hTable, missProbes, probes);
+    }
+}
+
+///
+// findEntry - finds the entry holding a key; a table that is growing may 
+//              still have it in the table it is growing out of
 // @param hTable - the hash table we are searching through
 // @param key - the key we are looking for
-// @return true if key is already in hTable, otherwise false
+// @return the entry, or NULL if key is not in hTable
 ///
-bool contains(HashTableADT hTable, void *key)
+static Entry *findEntry(HashTableADT hTable, void *key)
 {
     unsigned long index = hTable->hashFunction(key, hTable->capacity);
-    
-    // If entry is NULL, then this key is not in the hTable, return false
-    if(hTable->table[index] != NULL)
+    unsigned long probes = 0;
+    Entry *entry = searchChain(hTable, key, hTable->table[index], &probes);
+
+    // Buckets already moved over are left NULL
+    if(entry == NULL && hTable->oldTable != NULL)
     {
-        Entry *entry = hTable->table[index];
-        while(entry != NULL)
+        index = hTable->hashFunction(key, hTable->oldCapacity);
+        entry = searchChain(hTable, key, hTable->oldTable[index], &probes);
+    }
+
+    countLookup(hTable, entry, probes);
+    return entry;
+}
+
+///
+// findMany - finds the entries holding a batch of keys. Every key is hashed 
+//              and its buckets prefetched, then the first entry of every 
+//              chain is prefetched, and only then are the chains walked, so 
+//              the cache misses of independent lookups overlap instead of 
+//              being paid one after another.
+// @param hTable - the hash table we are searching through
+// @param keys - the keys we are looking for
+// @param count - the number of keys, at most BATCH_LOOKUPS
+// @param found - filled with the entry of each key, or NULL
+///
+static void findMany(HashTableADT hTable, void **keys, unsigned long count, 
+    Entry **found)
+{
+    unsigned long index[BATCH_LOOKUPS];
+    unsigned long oldIndex[BATCH_LOOKUPS];
+    Entry *first[BATCH_LOOKUPS];
+    Entry *oldFirst[BATCH_LOOKUPS];
+    bool growing = hTable->oldTable != NULL;
+
+    for(unsigned long i = 0; i < count; i++)
+    {
+        index[i] = hTable->hashFunction(keys[i], hTable->capacity);
+        PREFETCH(&hTable->table[index[i]]);
+
+        if(growing)
+        {
+            oldIndex[i] = hTable->hashFunction(keys[i], hTable->oldCapacity);
+            PREFETCH(&hTable->oldTable[oldIndex[i]]);
+        }
+    }
+
+    // Prefetching NULL is harmless, so empty buckets need no check
+    for(unsigned long i = 0; i < count; i++)
+    {
+        first[i] = hTable->table[index[i]];
+        PREFETCH(first[i]);
+
+        if(growing)
+        {
+            oldFirst[i] = hTable->oldTable[oldIndex[i]];
+            PREFETCH(oldFirst[i]);
+        }
+    }
+
+    for(unsigned long i = 0; i < count; i++)
+    {
+        unsigned long probes = 0;
+        Entry *entry = searchChain(hTable, keys[i], first[i], &probes);
+        if(entry == NULL && growing)
         {
-            if(hTable->equal(key, entry->key))
-            {
-                return true;
-            }
-            entry = entry->next;
+            entry = searchChain(hTable, keys[i], oldFirst[i], &probes);
         }
+
+        countLookup(hTable, entry, probes);
+        found[i] = entry;
     }
+}
 
-    return false;
+///
+// contains - determines if a key is in a hash table
+// @param hTable - the hash table we are searching through
+// @param key - the key we are looking for
+// @return true if key is already in hTable, otherwise false
+///
+bool contains(HashTableADT hTable, void *key)
+{
+    return findEntry(hTable, key) != NULL;
 }
 
 ///
-// resize - used to resize the hash function  after it reaches a certain load
-// @param oldHTable the older (smaller) hash function
-// @param newHTable a new empty hTable with a larger capacity
+// containsMany - determines which of a batch of keys are in a hash table
+// @param hTable - the hash table we are searching through
+// @param keys - the keys we are looking for
+// @param count - the number of keys
+// @param found - filled with whether each key is in hTable
 ///
-void resize(HashTableADT oldHTable, HashTableADT newHTable)
+void containsMany(HashTableADT hTable, void **keys, unsigned long count, 
+    bool *found)
 {
-    Entry ** oldTable = oldHTable->table;
-    
-    // Go through all of the old entries, putting them in the new table
-    for(unsigned long i = 0; i < oldHTable->capacity; i++)
+    Entry *entries[BATCH_LOOKUPS];
+
+    for(unsigned long start = 0; start < count; start += BATCH_LOOKUPS)
     {
-        if(oldTable[i] != NULL)
+        unsigned long batch = count - start < BATCH_LOOKUPS ? 
+            count - start : BATCH_LOOKUPS;
+
+        findMany(hTable, keys + start, batch, entries);
+        for(unsigned long i = 0; i < batch; i++)
         {
-            Entry *entry = oldTable[i];
-            Entry *first_entry = entry;
-            while(entry != NULL)
-            {
-                put(&newHTable, entry->key, entry->val);
-                entry = entry->next;
-            }
-
-            // remove old (now unused) entries
-            freeChain(first_entry);
+            found[start + i] = entries[i] != NULL;
         }
     }
 }
 
 ///
-// put - puts a key value pair into a hash table
-// @param hTable the table we are updating
-//   NOTE: put() requires a double pointer to a hash table struct so that is can
-//         successfully resize the hash table if need be
-// @param key the key being put into the hash table
-// @param val the value being put into the hash table
+// migrate - moves buckets of the table a hash table is growing out of into 
+//              its new table; the entries are relinked, not copied, and the 
+//              old table is freed once it is empty
+// @param hTable the growing hash table
+// @param count the most buckets to move
 ///
-void put(HashTableADT *hTablePtr, void *key, void *val)
+static void migrate(HashTableADT hTable, unsigned long count)
 {
-    HashTableADT hTable = *hTablePtr;
-    unsigned long index = hTable->hashFunction(key, hTable->capacity);
+    if(hTable->oldTable == NULL)
+    {
+        return;
+    }
 
-    // If this index is not NULL, then there have already been entries that 
-    // have hashed to this location
-    if(hTable->table[index] != NULL)
+#ifdef HASH_TABLE_STATS
+    unsigned long long start = nowNanos();
+#endif
+
+    while(count > 0 && hTable->oldTable != NULL)
     {
-        Entry *entry = hTable->table[index];
-        Entry *prev = NULL;
+        Entry *entry = hTable->oldTable[hTable->migrated];
+        hTable->oldTable[hTable->migrated] = NULL;
+
+        // Put each entry at the front of its chain in the new table
         while(entry != NULL)
         {
-            // If we find the key we are currently trying to insert, update 
-            // this entries val and exit
-            if(hTable->equal(key, entry->key))
-            {
-                entry->val = val;
-                return;
-            }
-            prev = entry;
-            entry = entry->next;
+            Entry *next = entry->next;
+            unsigned long index = 
+                hTable->hashFunction(entry->key, hTable->capacity);
+
+            entry->next = hTable->table[index];
+            hTable->table[index] = entry;
+            entry = next;
         }
 
-        // If we go through the whole chain and don't find the key we want 
-        // to insert, then make a new entry and add it to the end of the chain
-        Entry *newEntry = makeEntry(key, val);
+        hTable->migrated += 1;
+        count -= 1;
 
-        // This shouldn't happen, but should check anyway; if this check fails, 
-        // then don't add the entry
-        if(prev != NULL)
+        if(hTable->migrated == hTable->oldCapacity)
         {
-            prev->next = newEntry;
-            hTable->size += 1;
+            free(hTable->oldTable);
+            hTable->oldTable = NULL;
         }
     }
 
-    // This index has nothing there, put the new entry here
-    else
+#ifdef HASH_TABLE_STATS
+    hTable->counters.resizeNanos += nowNanos() - start;
+#endif
+}
+
+///
+// put - puts a key value pair into a hash table; a table that needs to grow 
+//   does so a few buckets per put(), so no single put() stalls on moving 
+//   every entry
+// @param hTable the table we are updating
+//   NOTE: put() takes a double pointer to a hash table struct so that it 
+//         could replace the table when resizing; the table now grows in 
+//         place, so the pointer is never changed
+// @param key the key being put into the hash table
+// @param val the value being put into the hash table
+///
+void put(HashTableADT *hTablePtr, void *key, void *val)
+{
+    HashTableADT hTable = *hTablePtr;
+
+    // Carry on moving entries over if the table is growing
+    migrate(hTable, MIGRATE_BUCKETS);
+
+    // If we find the key we are currently trying to insert, update this 
+    // entries val and exit
+    Entry *entry = findEntry(hTable, key);
+    if(entry != NULL)
     {
-        Entry *newEntry = makeEntry(key, val);
-        hTable->table[index] = newEntry;
-        hTable->size += 1;
+        entry->val = val;
+        return;
     }
 
-    // If our size is close to reach full capacity, we need to resize the hashtable
+    // Otherwise make a new entry at the front of its chain in the new table
+    unsigned long index = hTable->hashFunction(key, hTable->capacity);
+    Entry *newEntry = makeEntry(hTable, key, val);
+    newEntry->next = hTable->table[index];
+    hTable->table[index] = newEntry;
+    hTable->size += 1;
+
+    // If our size is close to reach full capacity, start growing into a 
+    // bigger table; the entries are moved over by the next few put()s
     if(hTable->size >= LOAD_FACTOR * (hTable->capacity))
     {
-        // Increase the size of our resize table and create a new, empty table
-        unsigned long new_capacity = hTable->capacity * 2 + 1;
-        HashTableADT newHTable = create(new_capacity, 
-            hTable->hashFunction, hTable->equal, hTable->printKeyVal);
-        
-        // fill the new table with all of the old entries
-        resize(hTable, newHTable);
-
-        // Deallocate the old hash table memory
-        HashTableADT oldHTable = hTable;
-        free(oldHTable->table);
-        free(oldHTable);
-        
-        // Set our hash table pointer to be the new table
-        *hTablePtr = newHTable;
+        // Anything left from the last time the table grew goes first
+        migrate(hTable, hTable->oldCapacity);
+
+#ifdef HASH_TABLE_STATS
+        unsigned long long start = nowNanos();
+#endif
+
+        hTable->oldTable = hTable->table;
+        hTable->oldCapacity = hTable->capacity;
+        hTable->migrated = 0;
+
+        hTable->capacity = hTable->capacity * 2 + 1;
+        hTable->table = makeBuckets(hTable->capacity);
+        hTable->resizes += 1;
+
+#ifdef HASH_TABLE_STATS
+        hTable->counters.resizeNanos += nowNanos() - start;
+#endif
     }
 }
 
@@ -245,26 +467,56 @@ void put(HashTableADT *hTablePtr, void *key, void *val)
 ///
 void *get(HashTableADT hTable, void *key)
 {
-    unsigned long index = hTable->hashFunction(key, hTable->capacity);
-    
-    // If the index is empty, then this key does not exist in hTable
-    if(hTable->table[index] != NULL)
+    Entry *entry = findEntry(hTable, key);
+    return entry != NULL ? entry->val : NULL;
+}
+
+///
+// getMany - grabs the values associated with a batch of keys from a hash 
+//              table; quicker than calling get() on each key once the table 
+//              no longer fits in the cache
+// @param hTable the hash table we are searching through
+// @param keys the keys associated with the values we are getting
+// @param count the number of keys
+// @param vals filled with the value associated with each key, or NULL
+///
+void getMany(HashTableADT hTable, void **keys, unsigned long count, 
+    void **vals)
+{
+    Entry *entries[BATCH_LOOKUPS];
+
+    for(unsigned long start = 0; start < count; start += BATCH_LOOKUPS)
     {
-        // Go through the chain of entries and find the one that matches our key
-        Entry *entry = hTable->table[index];
-        while(entry != NULL)
-        {
+        unsigned long batch = count - start < BATCH_LOOKUPS ? 
+            count - start : BATCH_LOOKUPS;
 
-            // Return the value
-            if(hTable->equal(key, entry->key))
-            {
-                return entry->val;
-            }
-            entry = entry->next;
+        findMany(hTable, keys + start, batch, entries);
+        for(unsigned long i = 0; i < batch; i++)
+        {
+            vals[start + i] = entries[i] != NULL ? entries[i]->val : NULL;
         }
     }
+}
 
-    return NULL;
+///
+// printChain - prints a chain of entries (used by printTable())
+// @param hTable the table the chain is in
+// @param entry the first entry of the chain
+///
+static void printChain(HashTableADT hTable, Entry *entry)
+{
+    while(entry != NULL)
+    {
+        hTable->printKeyVal(entry->key, entry->val);
+
+        // To indicate chaining (important to verify how well the 
+        // hashFunction is working)
+        if(entry->next != NULL)
+        {
+            printf("    ->");
+        }
+        entry = entry->next;
+    }
 }
 
 ///
@@ -273,25 +525,143 @@ void *get(HashTableADT hTable, void *key)
 ///
 void printTable(HashTableADT hTable)
 {
-    // Go through all of the entries in the table
+    // Go through all of the entries in the table, ignoring spots that have 
+    // not been filled
     for(unsigned long i = 0; i < hTable->capacity; i++)
     {
-        // Ignore spots that have not been filled
-        if(hTable->table[i] != NULL)
+        printChain(hTable, hTable->table[i]);
+    }
+
+    // And those still waiting to be moved over if the table is growing
+    if(hTable->oldTable != NULL)
+    {
+        printf("(growing)\n");
+        for(unsigned long i = hTable->migrated; i < hTable->oldCapacity; i++)
+        {
+            printChain(hTable, hTable->oldTable[i]);
+        }
+    }
+}
+
+///
+// countChains - adds the chains of an array of buckets to a table's 
+//              statistics
+// @param buckets the buckets
+// @param first, last the range of buckets counted
+// @param stats the statistics being gathered
+// @param positions adds the total position of the entries in their chains, 
+//         which is the number of keys compared to find each of them
+// @return the number of entries in the chains
+///
+static unsigned long countChains(Entry **buckets, unsigned long first, 
+    unsigned long last, HashTableStats *stats, double *positions)
+{
+    unsigned long entries = 0;
+
+    for(unsigned long i = first; i < last; i++)
+    {
+        unsigned long length = 0;
+        for(Entry *entry = buckets[i]; entry != NULL; entry = entry->next)
+        {
+            length += 1;
+        }
+
+        stats->chains[length < HASH_STATS_CHAINS ? length 
+                                                 : HASH_STATS_CHAINS - 1] += 1;
+        if(length > stats->maxChain)
         {
-            Entry *entry = hTable->table[i];
-            while(entry != NULL)
-            {
-                hTable->printKeyVal(entry->key, entry->val);
-
-                // To indicate chaining (important to verify how well the 
-                // hashFunction is working)
-                if(entry->next != NULL)
-                {
-                    printf("    ->");
-                }
-                entry = entry->next;
-            }
+            stats->maxChain = length;
         }
+        *positions += 0.5 * length * (length + 1);
+        entries += length;
+    }
+
+    return entries;
+}
+
+///
+// getStats - gathers statistics on how well a hash table spreads its keys; 
+//   walks the buckets, but calls neither the hash nor the equal function
+// @param hTable the table being measured
+// @return the statistics of the table
+///
+HashTableStats getStats(HashTableADT hTable)
+{
+    HashTableStats stats;
+    memset(&stats, 0, sizeof(HashTableStats));
+
+    stats.size = hTable->size;
+    stats.capacity = hTable->capacity;
+    stats.loadFactor = (double)hTable->size / hTable->capacity;
+    stats.resizes = hTable->resizes;
+    stats.growing = hTable->oldTable != NULL;
+
+    double positions = 0.0;
+    unsigned long inTable = countChains(hTable->table, 0, hTable->capacity, 
+        &stats, &positions);
+
+    // A lookup misses once it has gone through the chain of its bucket in 
+    // both tables; entries not yet moved over are found after the chain of 
+    // their bucket in the new table
+    double newChain = 0.0;
+    double oldChain = 0.0;
+    if(hTable->oldTable != NULL)
+    {
+        unsigned long inOld = countChains(hTable->oldTable, hTable->migrated,
+            hTable->oldCapacity, &stats, &positions);
+
+        newChain = (double)inTable / hTable->capacity;
+        oldChain = (double)inOld / hTable->oldCapacity;
+        positions += inOld * newChain;
+    }
+    else
+    {
+        newChain = (double)hTable->size / hTable->capacity;
+    }
+
+    stats.missProbes = newChain + oldChain;
+    stats.hitProbes = hTable->size > 0 ? positions / hTable->size : 0.0;
+
+#ifdef HASH_TABLE_STATS
+    const HashTableCounters *counters = &hTable->counters;
+    unsigned long misses = counters->lookups - counters->hits;
+
+    stats.counted = true;
+    stats.lookups = counters->lookups;
+    stats.countedHitProbes = counters->hits > 0 ? 
+        (double)counters->hitProbes / counters->hits : 0.0;
+    stats.countedMissProbes = misses > 0 ? 
+        (double)counters->missProbes / misses : 0.0;
+    stats.resizeSeconds = counters->resizeNanos * 1e-9;
+#endif
+
+    return stats;
+}
+
+///
+// printStats - prints the statistics of a hash table to std-out
+// @param hTable the table being measured
+///
+void printStats(HashTableADT hTable)
+{
+    HashTableStats stats = getStats(hTable);
+
+    printf("size %lu, capacity %lu, load factor %.3f%s\n", stats.size, 
+        stats.capacity, stats.loadFactor, stats.growing ? " (growing)" : "");
+    printf("chains:");
+    for(int i = 0; i < HASH_STATS_CHAINS; i++)
+    {
+        printf(" %d%s: %lu", i, i == HASH_STATS_CHAINS - 1 ? "+" : "", 
+            stats.chains[i]);
+    }
+    printf(", longest %lu\n", stats.maxChain);
+    printf("probes per hit %.3f, per miss %.3f, resizes %lu\n", 
+        stats.hitProbes, stats.missProbes, stats.resizes);
+
+    if(stats.counted)
+    {
+        printf("measured over %lu lookups: probes per hit %.3f, per miss "
+            "%.3f, %.6f s resizing\n", stats.lookups, stats.countedHitProbes,
+            stats.countedMissProbes, stats.resizeSeconds);
     }
 }
\ No newline at end of file
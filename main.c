@@ -9,11 +9,13 @@
 #ifdef __cplusplus
 #include <cstdlib>
 #include <iostream>
+#include <cstring>
 #else
 #include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
 #endif
 
 #ifdef __APPLE__ 
@@ -33,6 +35,9 @@
 #include "textureParams.h"
 #include "lightingParams.h"
 #include "viewParams.h"
+#include "jobSystem.h"
+#include "vertexCache.h"
+#include "hashBench.h"
 
 #ifdef __cplusplus
 using namespace std;
@@ -48,16 +53,63 @@ using namespace std;
 // Definition of PI
 #define PI 3.14159265358979323846
 
+// The number of chunks generated in each direction from the origin
+#define WORLD_RADIUS 8
+
+// The number of chunks along one side of the world
+#define WORLD_WIDTH (2 * WORLD_RADIUS + 1)
+
 // Definition for the max number of chunks we are creating
-#define NUM_CHUNKS 1
+#define NUM_CHUNKS (WORLD_WIDTH * WORLD_WIDTH)
+
+// The seed every chunk in the world is generated from
+#define WORLD_SEED 0x5EEDull
 
 // Storage for all the chunks
 // NOTE: We store the chunks as a 1d array, since we will most likely generate 
-//  the next chunks in an arbitrary order
+//  the next chunks in an arbitrary order; a chunk only depends on WORLD_SEED 
+//  and its own coordinates, so the order does not change the terrain
 Chunk *chunks[NUM_CHUNKS];
 
-// The total number of objects in the scene (subject to change)
-#define NUM_OBJ (NUM_CHUNKS * (CHUNK_SIZE * CHUNK_SIZE))
+// Every generated chunk, keyed by its coordinates; used to find the 
+// neighbours of a chunk while it is being generated
+ChunkMap chunkRegistry;
+
+// The total number of objects in the scene; one mesh per chunk for each 
+// level of detail, the mesh of chunk slot s at level l being object 
+// s * CHUNK_LOD_LEVELS + l
+#define NUM_OBJ (NUM_CHUNKS * CHUNK_LOD_LEVELS)
+
+// The camera distance within which chunks are drawn at full detail; each 
+// coarser level of detail reaches twice as far as the one before
+#define LOD_BASE_RANGE 16.0f
+
+// The part of each level's range over which its vertices morph into the 
+// next coarser level. A node is drawn at a finer level while the camera is 
+// within that level's range of it, so its far corner can be as much as its 
+// diagonal, sqrt(2) * CHUNK_SIZE / LOD_BASE_RANGE of the range, further out. 
+// The coarser level next to it must not have started morphing there, which 
+// needs a ratio below 2 - (1 + 0.707) = 0.29
+#define LOD_MORPH_RATIO 0.25f
+
+// A morph range no camera gets near, for meshes that never morph
+#define LOD_NO_MORPH 1.0e30f
+
+// The height error the adaptive full detail meshes may leave for each unit 
+// of distance across the ground from the camera. A height error covers 
+// about the same part of the screen wherever its ratio to the distance is 
+// the same, and this is the ratio the level 1 mesh already has where it 
+// takes over from level 0, since it drops the points whose variance of 
+// MIN_VAR to MAX_VAR sets them off from their neighbours
+#define ADAPTIVE_ERROR_SLOPE ((MAX_VAR - MIN_VAR) / LOD_BASE_RANGE)
+
+// How far the camera moves across the ground before the adaptive meshes are 
+// rebuilt around it
+#define ADAPTIVE_REMESH_DISTANCE 1.0f
+
+// Whether chunks upload a height map each instead of vertices; the vertex 
+// shader then displaces the shared grid meshes by the chunk's heights
+#define HEIGHT_MAP_MODE false
 
 bool moving = false;
 bool looking = false;
@@ -79,10 +131,41 @@ const float STEP_DISTANCE = 1.0f;
 float mouseSpeed = 0.0005f;
 
 // vertex and element array IDs
-// one for each object to be drawn
+// one vertex buffer for each object to be drawn, holding only what differs 
+// between chunks; the full detail meshes are adaptive, so outside of 
+// HEIGHT_MAP_MODE each chunk also has its own element array for those
 GLuint buffer[NUM_OBJ];
-GLuint ebuffer[NUM_OBJ];
-int numVerts[NUM_OBJ];
+GLuint ebuffer[NUM_CHUNKS];
+int numIndices[NUM_CHUNKS];
+GLenum indexType[NUM_CHUNKS];
+
+// The adaptive meshes are built for the camera at adaptiveEye (x and z), and 
+// rebuilt when it has moved too far from there; each move bumps 
+// adaptiveVersion, and a chunk whose meshedVersion is older is rebuilt 
+// before it is drawn at full detail, so all of the chunks drawn together 
+// are meshed for the same camera and meet at their borders
+float adaptiveEye[2];
+int adaptiveVersion = 0;
+int meshedVersion[NUM_CHUNKS];
+ShapeBuilder *adaptiveShape;
+
+// The height map of each chunk, in HEIGHT_MAP_MODE
+GLuint heightMaps[NUM_CHUNKS];
+
+// The grid points and element arrays of each level of detail, shared by 
+// every chunk
+TerrainGridPoint *gridPoints[CHUNK_LOD_LEVELS];
+GLuint gridBuffer[CHUNK_LOD_LEVELS];
+GLuint gridEbuffer[CHUNK_LOD_LEVELS];
+int gridIndices[CHUNK_LOD_LEVELS];
+GLenum gridIndexType[CHUNK_LOD_LEVELS];
+
+// Whether the chunk in each slot has been uploaded and can be drawn
+bool chunkReady[NUM_CHUNKS];
+
+// The most chunks handed to openGL each frame, so that a burst of finished 
+// chunks does not stall the render loop
+#define MAX_UPLOADS_PER_FRAME 4
 
 // Information for the textures
 int grassTexIndex, stoneTexIndex;
@@ -103,109 +186,370 @@ enum Direction
 // selectBuffers - sets the current buffers for a given program to a given object
 //
 // @param program - the program we are setting the buffers for
+// @param lod - the level of detail of the object
 // @param object - the object we are going to be using
+// @param elements - the element array the object is drawn with
 //
 ///
-void selectBuffers(GLuint program,  int object)
+void selectBuffers(GLuint program, int lod, int object, GLuint elements)
 {
+    //bind the grid points every chunk shares at this level of detail
+    glBindBuffer( GL_ARRAY_BUFFER , gridBuffer[lod] );
+
+    GLuint vGrid = glGetAttribLocation( program , "vGrid" );
+    glEnableVertexAttribArray( vGrid );
+    glVertexAttribPointer( vGrid , 2 , GL_SHORT , GL_FALSE, 
+                           sizeof (TerrainGridPoint) , BUFFER_OFFSET(0) );
+
     //bind buffers
-    glBindBuffer( GL_ARRAY_BUFFER , buffer[object] );
-    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER , ebuffer[object] );
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER , elements );
 
-    //set up the vertex arrays
-    int dataSize = numVerts[object] * 4 * sizeof (float);
-    int ndataSize = numVerts[object] * 3 * sizeof (float);
+    GLuint vTerrain = glGetAttribLocation( program , "vTerrain" );
+    GLuint vNormal = glGetAttribLocation( program, "vNormal" );
+
+    //height maps stand in for the chunk's vertices
+    if(HEIGHT_MAP_MODE)
+    {
+        glDisableVertexAttribArray( vTerrain );
+        glDisableVertexAttribArray( vNormal );
+        return;
+    }
+
+    glBindBuffer( GL_ARRAY_BUFFER , buffer[object] );
 
-    GLuint vPosition = glGetAttribLocation( program , "vPosition" );
-    glEnableVertexAttribArray( vPosition );
-    glVertexAttribPointer( vPosition , 4 , GL_FLOAT , GL_FALSE, 0 ,
-                           BUFFER_OFFSET(0) );
+    //set up the vertex arrays; the vertices are interleaved TerrainVertex 
+    //values, and tex coords are derived from the position in the shader
+    glEnableVertexAttribArray( vTerrain );
+    glVertexAttribPointer( vTerrain , 2 , GL_SHORT , GL_FALSE, 
+                           sizeof (TerrainVertex) ,
+                           BUFFER_OFFSET(TERRAIN_HEIGHT_OFFSET) );
     
-    GLuint vNormal = glGetAttribLocation( program, "vNormal" );
     glEnableVertexAttribArray( vNormal );
-    glVertexAttribPointer( vNormal, 3, GL_FLOAT, GL_FALSE, 0,
-                           BUFFER_OFFSET(dataSize) );
+    glVertexAttribPointer( vNormal, 2, GL_BYTE, GL_TRUE, 
+                           sizeof (TerrainVertex) ,
+                           BUFFER_OFFSET(TERRAIN_NORMAL_OFFSET) );
+
+}
+
+///
+// ChunkBuild - a chunk being generated and meshed on the job system, waiting 
+// to be uploaded to OpenGL on the main thread
+//
+// int slot            - the index of the chunk in chunks[]
+// ChunkCoord coord    - the coordinates of the chunk
+// Chunk *chunk        - the chunk being built
+// TerrainVertex *vertices[] - the packed vertices of the chunk's mesh at 
+//                             each level of detail
+// GLushort *heightMap       - the texels of the chunk's height map, made 
+//                             instead of the vertices in HEIGHT_MAP_MODE
+///
+typedef struct ChunkBuild_s
+{
+    int slot;
+    ChunkCoord coord;
+    Chunk *chunk;
+    TerrainVertex *vertices[CHUNK_LOD_LEVELS];
+    GLushort *heightMap;
+} ChunkBuild;
+
+///
+// generateChunkJob - job generating the heights of a chunk
+//
+// @param data - the ChunkBuild for the chunk
+///
+static void generateChunkJob(void *data)
+{
+    ChunkBuild *build = (ChunkBuild *)data;
+
+    // The main thread registers chunks as they are uploaded, while the 
+    // workers read the registry for the neighbours already generated; the 
+    // borders would line up without them, since a chunk only depends on the 
+    // seed and its coordinates
+    build->chunk = makeChunk(build->coord.x, build->coord.y);
+    generateChunk(build->chunk, WORLD_SEED, chunkRegistry);
+
+    for(int i = 0; i < CHUNK_SQUARES; i++)
+    {
+        // Assign the correct texture for this square
+        build->chunk->texId[i] = grassTexIndex;
+    }
+}
+
+///
+// meshChunkJob - job building the meshes of a chunk, one for every level of 
+// detail
+//
+// @param data - the ChunkBuild for the chunk
+///
+static void meshChunkJob(void *data)
+{
+    ChunkBuild *build = (ChunkBuild *)data;
+
+    if(HEIGHT_MAP_MODE)
+    {
+        build->heightMap = (GLushort *)malloc(
+            CHUNK_HEIGHT_MAP_SIZE * CHUNK_HEIGHT_MAP_SIZE * sizeof(GLushort));
+        if(build->heightMap == NULL)
+        {
+            perror( "height map allocation failed" );
+            exit( 1 );
+        }
+
+        makeChunkHeightMap(build->chunk, build->heightMap);
+    }
+
+    for(int lod = 0; lod < CHUNK_LOD_LEVELS && !HEIGHT_MAP_MODE; lod++)
+    {
+        // The vertices are packed straight into the block handed to openGL
+        TerrainVertex *vertices = (TerrainVertex *)malloc(
+            CHUNK_LOD_VERTICES(lod) * sizeof(TerrainVertex));
+        if(vertices == NULL)
+        {
+            perror( "mesh allocation failed" );
+            exit( 1 );
+        }
+
+        //make a shape, vertex for vertex with the shared grid points
+        makeChunkMesh(build->chunk, lod, gridPoints[lod], vertices);
+        build->vertices[lod] = vertices;
+    }
+}
+
+///
+// uploadChunk - hands a finished chunk over to OpenGL; run on the main thread
+// once its mesh job has finished
+//
+// @param data - the ChunkBuild for the chunk
+///
+static void uploadChunk(void *data)
+{
+    ChunkBuild *build = (ChunkBuild *)data;
+
+    chunks[build->slot] = build->chunk;
+    registerChunk(chunkRegistry, build->chunk);
+
+    if(HEIGHT_MAP_MODE)
+    {
+        heightMaps[build->slot] = makeHeightMap(CHUNK_HEIGHT_MAP_SIZE);
+        updateHeightMap(heightMaps[build->slot], CHUNK_HEIGHT_MAP_SIZE, 
+            build->heightMap);
+        free(build->heightMap);
+    }
+
+    for(int lod = 0; lod < CHUNK_LOD_LEVELS && !HEIGHT_MAP_MODE; lod++)
+    {
+        int index = build->slot * CHUNK_LOD_LEVELS + lod;
+        int dataSize = CHUNK_LOD_VERTICES(lod) * sizeof (TerrainVertex);
+
+        //generate the buffer
+        glGenBuffers( 1 , &buffer[index] );
+        //bind the buffer
+        glBindBuffer( GL_ARRAY_BUFFER , buffer[index] );
+        //buffer data
+        glBufferData( GL_ARRAY_BUFFER, dataSize, build->vertices[lod], 
+            GL_STATIC_DRAW );
+
+        free(build->vertices[lod]);
+    }
+
+    // The full detail mesh is built by meshAdaptiveChunk() once the chunk 
+    // is drawn at full detail. A height map can be updated after the chunk 
+    // is meshed, which would leave an adaptive mesh fitted to the old 
+    // heights, so in HEIGHT_MAP_MODE every level shares the indices of 
+    // createGridBuffers() instead
+    if(!HEIGHT_MAP_MODE)
+    {
+        glGenBuffers( 1 , &ebuffer[build->slot] );
+        meshedVersion[build->slot] = adaptiveVersion - 1;
+    }
+
+    chunkReady[build->slot] = true;
+    free(build);
+}
+
+///
+// meshAdaptiveChunk - builds the full detail mesh of a chunk for the camera 
+// at adaptiveEye and hands it over to openGL
+//
+// @param slot - the index of the chunk in chunks[]
+///
+static void meshAdaptiveChunk(int slot)
+{
+    Chunk *chunk = chunks[slot];
+
+    // The camera in grid steps from the chunk's first point, which is drawn 
+    // half a square back
+    float eyeX = (adaptiveEye[0] - chunk->chunkX + 0.5f) * TESS_FACTOR;
+    float eyeY = (adaptiveEye[1] - chunk->chunkY + 0.5f) * TESS_FACTOR;
+
+    shapeClear(adaptiveShape);
+    makeChunkAdaptiveMesh(chunk, eyeX, eyeY, 
+        ADAPTIVE_REMESH_DISTANCE * TESS_FACTOR, 
+        ADAPTIVE_ERROR_SLOPE / TESS_FACTOR, adaptiveShape);
+    shapeOptimizeVertexCache(adaptiveShape);
+
+    // 16 bit indices unless the mesh is too big for them
+    ElementArray elements = shapeElementArray(adaptiveShape);
+
+    //bind the buffer
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER , ebuffer[slot] );
+    //buffer data
+    glBufferData( GL_ELEMENT_ARRAY_BUFFER, elements.size,
+        elements.data, GL_DYNAMIC_DRAW );
+
+    //store the num indices and their type
+    numIndices[slot] = elements.count;
+    indexType[slot] = elements.type;
+    meshedVersion[slot] = adaptiveVersion;
+}
+
+///
+// createGridBuffers hands openGL the grid points and element arrays of every 
+// level of detail; these are the same for every chunk, so they are made once 
+// and shared by all of them. The points are kept in gridPoints, for the mesh 
+// jobs to lay out each chunk's vertices in the same order.
+///
+void createGridBuffers()
+{
+    ShapeBuilder *shape = makeShapeBuilder();
+
+    for(int lod = 0; lod < CHUNK_LOD_LEVELS; lod++)
+    {
+        TerrainGridPoint *points = (TerrainGridPoint *)malloc(
+            CHUNK_LOD_VERTICES(lod) * sizeof(TerrainGridPoint));
+        if(points == NULL)
+        {
+            perror( "grid allocation failed" );
+            exit( 1 );
+        }
+
+        shapeClear(shape);
+        makeGridMesh(lod, points, shape);
+        optimizeGridMesh(lod, points, shape);
+        gridPoints[lod] = points;
+
+        //generate the buffer
+        glGenBuffers( 1 , &gridBuffer[lod] );
+        //bind the buffer
+        glBindBuffer( GL_ARRAY_BUFFER , gridBuffer[lod] );
+        //buffer data
+        glBufferData( GL_ARRAY_BUFFER, 
+            CHUNK_LOD_VERTICES(lod) * sizeof (TerrainGridPoint), points, 
+            GL_STATIC_DRAW );
+
+        // The full detail level is drawn with each chunk's adaptive mesh, 
+        // unless the chunks are height maps
+        if(lod == 0 && !HEIGHT_MAP_MODE)
+        {
+            continue;
+        }
+
+        ElementArray elements = shapeElementArray(shape);
+
+        //generate the buffer
+        glGenBuffers( 1 , &gridEbuffer[lod] );
+        //bind the buffer
+        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER , gridEbuffer[lod] );
+        //buffer data
+        glBufferData( GL_ELEMENT_ARRAY_BUFFER, elements.size, elements.data, 
+            GL_STATIC_DRAW );
+
+        gridIndices[lod] = elements.count;
+        gridIndexType[lod] = elements.type;
+    }
+
+    destroyShapeBuilder(shape);
+}
+
+///
+// printMeshStats prints the average cache miss ratio of the shared grid 
+// meshes and of the adaptive meshes of a row of chunks, each seen from 
+// above its middle, before and after they are reordered for the vertex 
+// cache; needs no window or openGL context
+///
+void printMeshStats()
+{
+    ShapeBuilder *shape = makeShapeBuilder();
+    TerrainGridPoint *points = (TerrainGridPoint *)malloc(
+        CHUNK_MESH_VERTICES * sizeof(TerrainGridPoint));
+    if(points == NULL)
+    {
+        perror( "grid allocation failed" );
+        exit( 1 );
+    }
+
+    printf("ACMR on a %d entry FIFO cache\n", VERTEX_CACHE_SIZE);
+
+    for(int lod = 0; lod < CHUNK_LOD_LEVELS; lod++)
+    {
+        shapeClear(shape);
+        makeGridMesh(lod, points, shape);
+        float before = shapeACMR(shape, VERTEX_CACHE_SIZE);
+        optimizeGridMesh(lod, points, shape);
+
+        printf("grid lod %d:       %5d triangles  %.3f -> %.3f\n", lod, 
+            shapeIndices(shape) / 3, before, 
+            shapeACMR(shape, VERTEX_CACHE_SIZE));
+    }
 
-    GLuint vTexCoords = glGetAttribLocation( program , "vTexCoord" );
-    glEnableVertexAttribArray( vTexCoords );
-    glVertexAttribPointer( vTexCoords , 2 , GL_FLOAT , GL_FALSE, 0 ,
-                          BUFFER_OFFSET( dataSize + ndataSize) );
+    for(int x = -WORLD_RADIUS; x <= WORLD_RADIUS; x += WORLD_RADIUS)
+    {
+        Chunk *chunk = makeChunk(x, 0);
+        generateChunk(chunk, WORLD_SEED, NULL);
+
+        // Meshed for a camera over its middle, where it is finest
+        float middle = CHUNK_SIZE * TESS_FACTOR / 2.0f;
+        shapeClear(shape);
+        makeChunkAdaptiveMesh(chunk, middle, middle, 0.0f, 
+            ADAPTIVE_ERROR_SLOPE / TESS_FACTOR, shape);
+        float before = shapeACMR(shape, VERTEX_CACHE_SIZE);
+        shapeOptimizeVertexCache(shape);
+
+        printf("chunk (%3d, 0):    %5d triangles  %.3f -> %.3f\n", x, 
+            shapeIndices(shape) / 3, before, 
+            shapeACMR(shape, VERTEX_CACHE_SIZE));
+
+        destroyChunk(chunk);
+    }
 
+    free(points);
+    destroyShapeBuilder(shape);
 }
 
 ///
-// createShapes creates all of the shape's vertices/normals and
-// passes the information to openGL
+// createShapes queues up the generation and meshing of every chunk on the 
+// job system; each chunk is handed to openGL by uploadChunk() once it is done
 ///
 void createShapes()
 {
+    chunkRegistry = makeChunkRegistry();
+
     // Create all the objects
     for(int i = 0; i < NUM_CHUNKS; i++)
     {   
-        // Allocate memory for chunk
-        chunks[i] = makeChunk();
-
-        // Create each square for this chunk
-        for(int x = 0; x < CHUNK_SIZE; x++)
+        ChunkBuild *build = (ChunkBuild *)malloc(sizeof(ChunkBuild));
+        if(build == NULL)
         {
-            for(int y = 0; y < CHUNK_SIZE; y++)
-            {
-                // Assign the correct texture for this square
-                chunks[i]->squares[x][y]->texId = grassTexIndex;
-
-                // index into the various buffers for this object
-                int index = (i * CHUNK_SIZE) + (x * CHUNK_SIZE) + y;
-
-                //Clear shape
-                clearShape();
-                    
-                //make a shape
-                makeDefaultSquare();
-
-                // get the points for your shape
-                float *points = getVertices();
-                int dataSize = nVertices() * 4 * sizeof (float);
-
-                // Get normals for object
-                float *normals = getNormals();
-                int ndataSize = nVertices() * 3 * sizeof(float);
-
-                // Get tex coords for object
-                float *texCoords = getUV();
-                int tdataSize = nVertices() * 2 * sizeof (float);
-
-                // Get element data for object
-                GLushort *elements = getElements();
-                int edataSize = nVertices() * sizeof (GLushort);
-
-                //generate the buffer
-                glGenBuffers( 1 , &buffer[index] );
-                //bind the buffer
-                glBindBuffer( GL_ARRAY_BUFFER , buffer[index] );
-                //buffer data
-                glBufferData( GL_ARRAY_BUFFER, dataSize + tdataSize + ndataSize, 
-                    0, GL_STATIC_DRAW );
-                glBufferSubData ( GL_ARRAY_BUFFER, 0, dataSize, points);
-                glBufferSubData ( GL_ARRAY_BUFFER, dataSize, ndataSize, normals);
-                glBufferSubData ( GL_ARRAY_BUFFER, dataSize + ndataSize, 
-                    tdataSize, texCoords);
-
-                //generate the buffer
-                glGenBuffers( 1 , &ebuffer[index] );
-                //bind the buffer
-                glBindBuffer( GL_ELEMENT_ARRAY_BUFFER , ebuffer[index] );
-                //buffer data
-                glBufferData( GL_ELEMENT_ARRAY_BUFFER, edataSize,
-                    elements, GL_STATIC_DRAW );
-
-                //store the num verts
-                numVerts[index] = nVertices();
-            }
+            perror( "chunk build allocation failed" );
+            exit( 1 );
         }
-    }
+        build->slot = i;
+        build->coord.x = i % WORLD_WIDTH - WORLD_RADIUS;
+        build->coord.y = i / WORLD_WIDTH - WORLD_RADIUS;
+        build->chunk = NULL;
+        for(int lod = 0; lod < CHUNK_LOD_LEVELS; lod++)
+        {
+            build->vertices[lod] = NULL;
+        }
+        build->heightMap = NULL;
+
+        Job *generate = makeJob(generateChunkJob, NULL, build);
+        Job *mesh = makeJob(meshChunkJob, uploadChunk, build);
+        jobDependsOn(mesh, generate);
 
-    //Clear final shape that was generated
-    clearShape();
+        submitJob(generate);
+        submitJob(mesh);
+    }
 }
 
 ///
@@ -349,7 +693,12 @@ void init() {
     grassTexIndex = loadTexture(GRASS_IMAGE);
     stoneTexIndex = loadTexture(STONE_IMAGE);
 
-    // create the geometry for your shapes.
+    // start the workers and queue up the geometry for your shapes.
+    createGridBuffers();
+    adaptiveShape = makeShapeBuilder();
+    adaptiveEye[0] = eyePoint[0];
+    adaptiveEye[1] = eyePoint[2];
+    jobSystemStart(0);
     createShapes();
 
     // set default look position of the camera (looking directly at the scene)
@@ -358,6 +707,170 @@ void init() {
 }
 
 
+///
+// lodRange - the camera distance out to which a level of the LOD quadtree is 
+// used
+//
+// @param level - the level of the quadtree
+//
+// @return The range of the level
+///
+static float lodRange(int level)
+{
+    return LOD_BASE_RANGE * (float)(1 << level);
+}
+
+///
+// lodNodeDistance - the distance across the ground from the camera to a node 
+// of the LOD quadtree. Heights are left out, as the vertex shader leaves 
+// them out of the distances it morphs by: a node only ever meets a coarser 
+// one where its own vertices are fully morphed if both measure the same way.
+//
+// @param x0, y0 - the coordinates of the node's first chunk
+// @param level - the level of the node; it covers 2^level chunks each way
+//
+// @return The distance, 0 when the camera is above the node
+///
+static float lodNodeDistance(int x0, int y0, int level)
+{
+    // Every point of a chunk is moved back by half a square when drawn
+    float minX = x0 * CHUNK_SIZE - 0.5f;
+    float minZ = y0 * CHUNK_SIZE - 0.5f;
+    float maxX = minX + (float)((1 << level) * CHUNK_SIZE);
+    float maxZ = minZ + (float)((1 << level) * CHUNK_SIZE);
+
+    float dx = fmaxf(fmaxf(minX - eyePoint[0], eyePoint[0] - maxX), 0.0f);
+    float dz = fmaxf(fmaxf(minZ - eyePoint[2], eyePoint[2] - maxZ), 0.0f);
+
+    return sqrtf(dx * dx + dz * dz);
+}
+
+///
+// drawChunk - draws one chunk at the level of detail of a quadtree level
+//
+// @param cx, cy - the coordinates of the chunk
+// @param level - the level of the quadtree node the chunk is drawn for
+///
+static void drawChunk(int cx, int cy, int level)
+{
+    // Skip chunks outside the world or still being generated
+    if(cx < -WORLD_RADIUS || cx > WORLD_RADIUS || 
+        cy < -WORLD_RADIUS || cy > WORLD_RADIUS)
+    {
+        return;
+    }
+
+    int slot = (cy + WORLD_RADIUS) * WORLD_WIDTH + (cx + WORLD_RADIUS);
+    if(!chunkReady[slot])
+    {
+        return;
+    }
+
+    // Levels past the coarsest mesh reuse it, and it never morphs
+    int lod = level < CHUNK_LOD_LEVELS - 1 ? level : CHUNK_LOD_LEVELS - 1;
+    if(lod == CHUNK_LOD_LEVELS - 1)
+    {
+        setUpLod(program, (float)(1 << lod), LOD_NO_MORPH, 2.0f * LOD_NO_MORPH);
+    }
+    else
+    {
+        float end = lodRange(lod);
+        float start = end - 
+            (end - (lod > 0 ? lodRange(lod - 1) : 0.0f)) * LOD_MORPH_RATIO;
+        setUpLod(program, (float)(1 << lod), start, end);
+    }
+
+    Chunk *cChunk = chunks[slot];
+    GLfloat *scale = cChunk->scale;
+    GLfloat *rotate = cChunk->rotate;
+
+    clearTransforms(program);
+
+    // TODO: Move texture to individual square level
+    setUpTexture(program, cChunk->texId[0]);
+    setUpHeightMap(program, HEIGHT_MAP_MODE ? heightMaps[slot] : 0, 
+        CHUNK_HEIGHT_MAP_SIZE);
+
+    // set up transformations 
+    setUpTransforms( program,
+        scale[0], scale[1], scale[2],
+        rotate[0] + angles[0], rotate[1] + angles[1], rotate[2] + angles[2],
+        cChunk->chunkX, 0.0f, cChunk->chunkY
+    );
+
+    //setup uniform variables to shader; the full detail mesh is the 
+    //chunk's own unless it is drawn from a height map, the others share 
+    //the grid's element arrays
+    int object = slot * CHUNK_LOD_LEVELS + lod;
+    bool adaptive = (lod == 0 && !HEIGHT_MAP_MODE);
+    if(adaptive && meshedVersion[slot] != adaptiveVersion)
+    {
+        meshAdaptiveChunk(slot);
+    }
+
+    GLuint elements = adaptive ? ebuffer[slot] : gridEbuffer[lod];
+    int count = adaptive ? numIndices[slot] : gridIndices[lod];
+    GLenum type = adaptive ? indexType[slot] : gridIndexType[lod];
+
+    selectBuffers(program, lod, object, elements);
+    // draw your shape
+    glDrawElements(GL_TRIANGLES, count, type, (void *)0 );
+}
+
+///
+// drawLodNode - draws a node of the LOD quadtree over the chunks of the 
+// world; nodes too close to the camera for their level are split up, and 
+// the parts of them out of range of the finer level are drawn at this one
+//
+// @param x0, y0 - the coordinates of the node's first chunk
+// @param level - the level of the node; it covers 2^level chunks each way
+///
+static void drawLodNode(int x0, int y0, int level)
+{
+    int size = 1 << level;
+
+    // Skip nodes wholly outside the world
+    if(x0 > WORLD_RADIUS || y0 > WORLD_RADIUS || 
+        x0 + size <= -WORLD_RADIUS || y0 + size <= -WORLD_RADIUS)
+    {
+        return;
+    }
+
+    if(level == 0 || lodNodeDistance(x0, y0, level) >= lodRange(level - 1))
+    {
+        for(int x = x0; x < x0 + size; x++)
+        {
+            for(int y = y0; y < y0 + size; y++)
+            {
+                drawChunk(x, y, level);
+            }
+        }
+        return;
+    }
+
+    int half = size / 2;
+    for(int child = 0; child < 4; child++)
+    {
+        int cx = x0 + (child & 1) * half;
+        int cy = y0 + (child >> 1) * half;
+
+        if(lodNodeDistance(cx, cy, level - 1) >= lodRange(level - 1))
+        {
+            for(int x = cx; x < cx + half; x++)
+            {
+                for(int y = cy; y < cy + half; y++)
+                {
+                    drawChunk(x, y, level);
+                }
+            }
+        }
+        else
+        {
+            drawLodNode(cx, cy, level - 1);
+        }
+    }
+}
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -387,49 +900,27 @@ void display( void )
         0.0f, 1.0f, 0.0f
     );
 
-    // Set up and draw all of the objects
-    int i;
-    GLfloat *scale;
-    GLfloat *rotate;
-    GLfloat translate[3];
+    // Set up the scale of the packed terrain vertices
+    setUpTerrain(program, 1.0f / TESS_FACTOR, 1.0f / HEIGHT_PRECISION);
 
-    // Display terrain blocks
-    for(i = 0; i < NUM_CHUNKS; i++)
-    {            
-        Chunk *cChunk = chunks[i];
+    // Rebuild the adaptive meshes around the camera once it has moved far 
+    // enough from where they were built
+    if(hypotf(eyePoint[0] - adaptiveEye[0], eyePoint[2] - adaptiveEye[1]) > 
+        ADAPTIVE_REMESH_DISTANCE)
+    {
+        adaptiveEye[0] = eyePoint[0];
+        adaptiveEye[1] = eyePoint[2];
+        adaptiveVersion++;
+    }
 
-        for(int x = 0; x < CHUNK_SIZE; x++)
-        {
-            for(int y = 0; y < CHUNK_SIZE; y++)
-            {
-                int index = (NUM_CHUNKS * i) + (CHUNK_SIZE * x) + y;
-
-                Square *cSquare = cChunk->squares[x][y];
-                clearTransforms(program);
-                scale = cChunk->scale;
-                rotate = cChunk->rotate;
-                translate[0] = cChunk->chunkX + cSquare->x; 
-                translate[1] = cSquare->z;
-                translate[2] = cChunk->chunkY + cSquare->y;
-                
-                // TODO: Move texture to individual square level
-                setUpTexture(program, cSquare->texId);            
-
-                // set up transformations 
-                setUpTransforms( program,
-                    scale[0], scale[1], scale[2],
-                    rotate[0] + angles[0], rotate[1] + angles[1], rotate[2] + angles[2],
-                    translate[0], translate[1], translate[2]
-                );
-
-                //setup uniform variables to shader
-                selectBuffers(program, index);
-                // draw your shape
-                glDrawElements(GL_TRIANGLES, numVerts[index], 
-                    GL_UNSIGNED_SHORT, (void *)0 );
-            }
-        }
+    // Display terrain blocks, walking the LOD quadtree down from a root 
+    // that covers the whole world
+    int rootLevel = 0;
+    while((1 << rootLevel) < WORLD_WIDTH)
+    {
+        rootLevel++;
     }
+    drawLodNode(-WORLD_RADIUS, -WORLD_RADIUS, rootLevel);
 
     // swap the buffers
     glutSwapBuffers();
@@ -454,6 +945,9 @@ void animate( void )
         glutWarpPointer(xOrigin, yOrigin);
     }
 
+    // Upload any chunks the workers have finished
+    jobSystemPollCompleted(MAX_UPLOADS_PER_FRAME);
+
     glutPostRedisplay();
 }
 
@@ -575,13 +1069,27 @@ void keyboard( unsigned char key, int x, int y )
 // main function entry point of the program; initializes all of the openGL 
 // information and starts drawing the scene
 //
-// @param argc - number of command line arguments; unused
-// @param argv - command line args; unused
+// @param argc - number of command line arguments
+// @param argv - command line args; --mesh-stats prints the vertex cache 
+//        statistics of the meshes, and --hash-bench times the hash table 
+//        lookups, and both exit without opening a window
 //
 // @return 0 on successful execution
 ///
 int main (int argc, char **argv)
 {
+    if( argc > 1 && strcmp( argv[1], "--mesh-stats" ) == 0 )
+    {
+        printMeshStats();
+        return 0;
+    }
+
+    if( argc > 1 && strcmp( argv[1], "--hash-bench" ) == 0 )
+    {
+        hashBench();
+        return 0;
+    }
+
     glutInit( &argc, argv );
     glutInitDisplayMode( GLUT_RGBA | GLUT_DOUBLE | GLUT_DEPTH );
     glutInitWindowSize( 512, 512 );
@@ -600,6 +1108,9 @@ int main (int argc, char **argv)
     glutPassiveMotionFunc( passiveMotion );
     glutMainLoop();
 
+    jobSystemStop();
+    destroyChunkMap(chunkRegistry);
+
     for(int i = 0; i < NUM_CHUNKS; i++)
     {
         destroyChunk(chunks[i]);
@@ -18,6 +18,10 @@
 #include <stdbool.h>
 #endif
 
+#include <stdint.h>
+
+#include "chunkMap.h"
+
 #ifdef __APPLE__ 
 #include <GLUT/GLUT.h>
 #include <OpenGL/gl.h>
@@ -29,26 +33,89 @@
 #include <SOIL.h>
 #endif
 
+#include "simpleShape.h"
+#include "terrainVertex.h"
+
 // The tesselation factor of each square in the chunk
 #define TESS_FACTOR 1
 
-#define NUM_POINTS (TESS_FACTOR + 1) * 2
+// The number of tessellated points of each square
+#define NUM_POINTS ((TESS_FACTOR + 1) * (TESS_FACTOR + 1))
+
+// Index of the tessellated point (i, j) of a square into Square.points
+#define POINT_INDEX(i, j) ((i) * (TESS_FACTOR + 1) + (j))
 
 // The size of chunk (Total number of squares: CHUNK_SIZE * CHUNK_SIZE)
 #define CHUNK_SIZE 8
 
+// The distance (in squares) between the sampled heights of a chunk
 #define SAMPLE_SIZE 5
 
+// The range of the sampled heights
 #define MAX_HEIGHT 64.0f
 #define MIN_HEIGHT -64.0f
 
+// The range of the variance added to each tessellated point
 #define MAX_VAR 1.0f
 #define MIN_VAR -1.0f
 
+// Heights are rounded to multiples of 1/HEIGHT_PRECISION, which makes 
+// splitting a height into a square's z and a point's variance (and adding 
+// them back together) exact. Terrain meshes store heights as 16 bit counts 
+// of these steps, so (MAX_HEIGHT + MAX_VAR) * HEIGHT_PRECISION must stay 
+// below 32768
+#define HEIGHT_PRECISION 256.0f
+
+// The total number of squares in a chunk
+#define CHUNK_SQUARES (CHUNK_SIZE * CHUNK_SIZE)
+
+// Index of the square at (x, y) into the per-square arrays of a Chunk
+#define SQUARE_INDEX(x, y) ((x) * CHUNK_SIZE + (y))
+
+// The number of tessellated points along one side of a chunk; neighbouring 
+// squares share the points on their common edge
+#define CHUNK_GRID_SIZE (CHUNK_SIZE * TESS_FACTOR + 1)
+
+// The sides of a chunk, indexing the apron of points just outside of it
+#define APRON_WEST 0
+#define APRON_EAST 1
+#define APRON_SOUTH 2
+#define APRON_NORTH 3
+
+// The number of levels of detail a chunk is meshed at. Level l keeps every 
+// 2^l-th point, so CHUNK_SIZE * TESS_FACTOR must be divisible by 
+// 2^(CHUNK_LOD_LEVELS - 1); the adaptive mesher needs it to be a power of 2
+#define CHUNK_LOD_LEVELS 4
+
+// The number of points along one side of a chunk's mesh at a level of detail
+#define CHUNK_LOD_GRID_SIZE(lod) (((CHUNK_SIZE * TESS_FACTOR) >> (lod)) + 1)
+
+// The number of vertices and indices in the grid mesh of a chunk at a level 
+// of detail
+#define CHUNK_LOD_VERTICES(lod) \
+    (CHUNK_LOD_GRID_SIZE(lod) * CHUNK_LOD_GRID_SIZE(lod))
+#define CHUNK_LOD_INDICES(lod) \
+    ((CHUNK_LOD_GRID_SIZE(lod) - 1) * (CHUNK_LOD_GRID_SIZE(lod) - 1) * 6)
+
+// The number of vertices and indices in the full detail mesh of a chunk
+#define CHUNK_MESH_VERTICES CHUNK_LOD_VERTICES(0)
+#define CHUNK_MESH_INDICES CHUNK_LOD_INDICES(0)
+
+// The number of texels along one side of a chunk's height map: one for 
+// every point of the chunk and of its apron
+#define CHUNK_HEIGHT_MAP_SIZE (CHUNK_GRID_SIZE + 2)
+
+// Height map texels hold a height in steps of 1/HEIGHT_PRECISION plus this, 
+// so they fit in an unsigned 16 bit texel
+#define HEIGHT_MAP_OFFSET 32768
+
 ///
 // Square - structure containing all the information for an individual square 
 //  in the chunk
 //
+// NOTE: Chunks no longer store Squares directly; this is a copy of one 
+//  square's fields, filled in by getSquare() and written back by setSquare()
+//
 // GLfloat z        - The base z-value of this particular square inside the 
 //                    chunk, either chosen when sampling, OR interpolated
 // GLfloat x, y     - The normalized x, y coordinates inside of the chunk
@@ -67,33 +134,124 @@ typedef struct Square_s
     bool finished;
 } Square;
 
+///
+// ChunkCoord - the integer coordinates of a chunk in the grid of chunks 
+//  making up the world; the chunk at (x, y) starts at x * CHUNK_SIZE, 
+//  y * CHUNK_SIZE in the world
+///
+typedef struct ChunkCoord_s
+{
+    int x, y;
+} ChunkCoord;
+
 ///
 // Chunk - structure containing all the information about this chunk
 //
+// The fields of every square are kept as struct-of-arrays inside of the chunk,
+// so a chunk is a single allocation and a pass over one field walks 
+// contiguous memory. Index the per-square arrays with SQUARE_INDEX(x, y); the
+// x, y coordinates of a square are implied by its index.
+//
+// ChunkCoord coord     - the coordinates of this chunk in the grid of chunks
 // GLfloat chunkX,chunkY- x, y coordinates of this chunk in the world
-//  TODO: work terrain generation algorithm to work with multiple chunks
 // GLfloat rotate       - Vector for determining how each sqaure in the chunk 
 //                        should be rotated (Default is no rotation)
 // GLfloat scale        - Vector to determine scaling of chunk (Default is none)
-// Square squares[][]   - 2-d array holding all the info for the squares
+// GLfloat z[]          - The base z-value of each square
+// GLfloat points[][]   - The variance of each tessellated point; points[p] 
+//                        holds the variance of point p for every square
+// int texId[]          - The texture id of each square
+// bool finished[]      - Set when the matching square has been set
+// GLfloat apron[][]    - The heights of the points one step outside of each 
+//                        side of the chunk (indexed by APRON_*, then by the 
+//                        point along that side); these belong to the 
+//                        neighbouring chunks, but are generated with this 
+//                        one so its edge normals never wait on a neighbour
+// GLfloat errors[]     - The error hierarchy of the adaptive mesher, indexed 
+//                        by point like a chunk's grid: the largest height 
+//                        error left by not splitting at each point, or at 
+//                        any point below it in the hierarchy
 ///
 typedef struct  Chunk_s
 {
+    ChunkCoord coord;
     GLfloat chunkX, chunkY;
     GLfloat rotate[3];
     GLfloat scale[3];
-    Square *squares[CHUNK_SIZE][CHUNK_SIZE];
+    GLfloat z[CHUNK_SQUARES];
+    GLfloat points[NUM_POINTS][CHUNK_SQUARES];
+    int texId[CHUNK_SQUARES];
+    bool finished[CHUNK_SQUARES];
+    GLfloat apron[4][CHUNK_GRID_SIZE];
+    GLfloat errors[CHUNK_GRID_SIZE * CHUNK_GRID_SIZE];
 
 } Chunk;
 
 
-// Allocates space for a single chunk
-Chunk *makeChunk();
+// Allocates space for the chunk at (coordX, coordY) in the grid of chunks
+Chunk *makeChunk(int coordX, int coordY);
 
 // Frees all memory allocated to a chunk
 void destroyChunk(Chunk *chunk);
 
+// Copies the fields of the square at (x, y) out of a chunk
+Square getSquare(const Chunk *chunk, int x, int y);
+
+// Writes the fields of a square back into a chunk at (x, y)
+void setSquare(Chunk *chunk, int x, int y, const Square *square);
+
+// Generates the heights of every square in a chunk from the world's seed, 
+// matching the borders of any neighbours in the registry
+void generateChunk(Chunk *chunk, uint64_t worldSeed, ChunkMap registry);
+
+// Gets the height of the tessellated point (gx, gy) of a chunk
+GLfloat getPointHeight(const Chunk *chunk, int gx, int gy);
+
+// Creates an empty registry of chunks, keyed by their coordinates; any 
+// thread may look chunks up while others add them
+ChunkMap makeChunkRegistry();
+
+// Adds a chunk to a registry
+void registerChunk(ChunkMap registry, Chunk *chunk);
+
+// Finds the chunk at (x, y) in a registry, or NULL if there is none; the 
+// registry must be pinned with chunkMapPin() while the chunk is used
+Chunk *findChunk(ChunkMap registry, int x, int y);
+
 // Populates the float vectors for a single square shape (to be passed to OpenGL)
 void makeDefaultSquare();
 
+// Populates the float vectors for the square at (x, y) using its heights
+void makeChunkSquare(const Chunk *chunk, int x, int y);
+
+// Fills CHUNK_LOD_VERTICES(lod) grid points, and the indices of a shape 
+// builder, with the indexed grid mesh every chunk shares at a level of detail
+void makeGridMesh(int lod, TerrainGridPoint *points, ShapeBuilder *shape);
+
+// Reorders a grid mesh made by makeGridMesh() for the vertex cache and, 
+// above level 0, for vertex fetch
+void optimizeGridMesh(int lod, TerrainGridPoint *points, ShapeBuilder *shape);
+
+// Fills the CHUNK_LOD_VERTICES(lod) packed vertices of a chunk's grid mesh 
+// at a level of detail, one for each of its grid points
+void makeChunkMesh(const Chunk *chunk, int lod, 
+    const TerrainGridPoint *points, TerrainVertex *vertices);
+
+// Fills the CHUNK_HEIGHT_MAP_SIZE * CHUNK_HEIGHT_MAP_SIZE texels of a height 
+// map of a chunk and its apron, for drawing it by displacing the grid mesh 
+// in the vertex shader
+void makeChunkHeightMap(const Chunk *chunk, GLushort *texels);
+
+// Recomputes the error hierarchy of a chunk from its heights; done by 
+// generateChunk(), and needed again whenever the heights are changed
+void computeChunkErrors(Chunk *chunk);
+
+// Fills the indices of a shape builder with an adaptive mesh of a chunk for 
+// a camera at (eyeX, eyeY) give or take eyeRadius, in grid steps from the 
+// chunk's first point; a point's height may be off by up to errorSlope per 
+// grid step of its distance from the camera. The indices are into the full 
+// detail grid mesh
+void makeChunkAdaptiveMesh(const Chunk *chunk, float eyeX, float eyeY,
+    float eyeRadius, float errorSlope, ShapeBuilder *shape);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,58 @@
+///
+// chunkRandom.h
+//
+// Counter-based random numbers for terrain generation. There is no shared 
+// generator state: every value is a pure function of a key and a counter, 
+// and keys are derived from the world seed and integer coordinates (of a 
+// chunk, a tessellated point, ...). Anything generated this way comes out the 
+// same no matter which thread generates it or in what order.
+//
+// @author T. Wilgenbusch
+///
+
+#ifndef _CHUNKRANDOM_H_
+#define _CHUNKRANDOM_H_
+
+#include <stdint.h>
+
+///
+// randomMix - the SplitMix64 mixing function
+//
+// @param x - the value being mixed
+//
+// @return A well distributed 64-bit hash of x
+///
+uint64_t randomMix(uint64_t x);
+
+///
+// randomKey - derives the key for an integer coordinate in a world
+//
+// @param worldSeed - the seed of the world
+// @param x, y - the coordinate
+//
+// @return The key for (x, y)
+///
+uint64_t randomKey(uint64_t worldSeed, int x, int y);
+
+///
+// randomAt - the random value number counter of a key
+//
+// @param key - a key from randomKey()
+// @param counter - which value of the key to return
+//
+// @return A uniformly distributed 64-bit value
+///
+uint64_t randomAt(uint64_t key, uint64_t counter);
+
+///
+// randomRangeAt - randomAt() mapped onto a range of floats
+//
+// @param key - a key from randomKey()
+// @param counter - which value of the key to return
+// @param min, max - the bounds of the range
+//
+// @return A value between min and max
+///
+float randomRangeAt(uint64_t key, uint64_t counter, float min, float max);
+
+#endif
@@ -12,6 +12,12 @@
 
 #include <sys/types.h>
 
+///
+// Alignment of the storage of every floatVector, in bytes; enough for
+// aligned AVX loads and a whole cache line
+///
+#define FLOAT_VECTOR_ALIGNMENT 64
+
 ///
 // define an alternative to the STL vector<float> class
 ///
@@ -19,8 +25,9 @@ typedef struct floatVector
 {
 	size_t size;	// number of occupied slots in the vector
 	size_t length;	// total number of slots in the vector
-	size_t growth;	// how many slots to add when growing the vector
+	size_t growth;	// the fewest slots to add when growing the vector
 	float *vec;	// the vector itself
+	int external;	// whether vec is storage owned by someone else
 } floatVector_t;
 
 ///
@@ -39,6 +46,12 @@ size_t floatVectorGrowthFactor( floatVector_t *vec, size_t size );
 ///
 void floatVectorClear( floatVector_t *vec );
 
+///
+// floatVectorReserve -- make room for at least length floats, so that
+// pushing up to that many never reallocates
+///
+void floatVectorReserve( floatVector_t *vec, size_t length );
+
 ///
 // floatVectorPushBack -- add a float to the end of the vector,
 // automatically extending the vector if need be
@@ -48,6 +61,28 @@ void floatVectorClear( floatVector_t *vec );
 ///
 void floatVectorPushBack( floatVector_t *vec, float coord );
 
+///
+// floatVectorPushBackN -- add n floats (a whole vertex, triangle, ...)
+// to the end of the vector in one call; values may point into vec
+///
+void floatVectorPushBackN( floatVector_t *vec, const float *values, size_t n );
+
+///
+// floatVectorAppend -- add the contents of other to the end of vec;
+// other may be vec itself
+///
+void floatVectorAppend( floatVector_t *vec, const floatVector_t *other );
+
+///
+// floatVectorUseBuffer -- empty a floatVector and have it fill the
+// caller's buffer, which may hold up to length floats
+//
+// The buffer is never freed or reallocated by the vector; if more than
+// length floats are pushed, the contents move to storage of the
+// vector's own. The buffer need not be aligned.
+///
+void floatVectorUseBuffer( floatVector_t *vec, float *buffer, size_t length );
+
 ///
 // Pseudo-function: return the count of elements in a floatVector_t
 //
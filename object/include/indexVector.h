@@ -0,0 +1,54 @@
+///
+// indexVector.h
+//
+// A growable array of vertex indices, modeled after floatVector_t; used for 
+// the element data of indexed meshes.
+//
+// @author T. Wilgenbusch
+///
+
+#ifndef _INDEXVECTOR_H_
+#define _INDEXVECTOR_H_
+
+#include <sys/types.h>
+
+///
+// define an alternative to the STL vector<unsigned int> class
+///
+typedef struct indexVector 
+{
+	size_t size;	// number of occupied slots in the vector
+	size_t length;	// total number of slots in the vector
+	size_t growth;	// how many slots to add when growing the vector
+	unsigned int *vec;	// the vector itself
+} indexVector_t;
+
+///
+// Manipulation functions
+///
+
+///
+// indexVectorClear -- return an indexVector to its original state
+///
+void indexVectorClear( indexVector_t *vec );
+
+///
+// indexVectorReserve -- make room for at least length indices
+///
+void indexVectorReserve( indexVector_t *vec, size_t length );
+
+///
+// indexVectorPushBack -- add an index to the end of the vector,
+// automatically extending the vector if need be
+//
+// If the vector must be extended and the memory reallocation
+// fails, this method will print an error message and exit.
+///
+void indexVectorPushBack( indexVector_t *vec, unsigned int index );
+
+///
+// Pseudo-function: return the count of elements in an indexVector_t
+///
+#define indexVectorSize(ivp)  ((ivp)->size)
+
+#endif
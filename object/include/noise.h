@@ -0,0 +1,142 @@
+///
+// noise.h
+//
+// Gradient (Perlin) noise and fractal Brownian motion for generating terrain
+// heights. Every function has a batch version that evaluates many positions
+// per call using AVX2 (8 positions at a time) or SSE2 (4 at a time) when the
+// compiler has them enabled, and a scalar reference version that gives
+// identical results.
+//
+// @author T. Wilgenbusch
+///
+
+#ifndef _NOISE_H_
+#define _NOISE_H_
+
+// The number of positions the widest enabled vector path evaluates at once
+#if defined(__AVX2__)
+#define NOISE_BATCH 8
+#elif defined(__SSE2__)
+#define NOISE_BATCH 4
+#else
+#define NOISE_BATCH 1
+#endif
+
+// Added to the seed for each successive octave so octaves are uncorrelated
+#define NOISE_OCTAVE_SEED 0x9E3779B9u
+
+// Defaults used by fbm2Batch()
+#ifndef NOISE_OCTAVES
+#define NOISE_OCTAVES 4
+#endif
+
+#ifndef NOISE_LACUNARITY
+#define NOISE_LACUNARITY 2.0f
+#endif
+
+#ifndef NOISE_GAIN
+#define NOISE_GAIN 0.5f
+#endif
+
+///
+// noise2 - scalar reference 2-d gradient noise
+//
+// @param x, y - the position being sampled
+// @param seed - selects the gradients used
+//
+// @return The noise value at (x, y), roughly between -1 and 1
+///
+float noise2(float x, float y, unsigned int seed);
+
+///
+// noise2Batch - evaluates noise2() at n positions
+//
+// @param x, y - the positions being sampled
+// @param out - the array the n noise values are written to
+// @param n - the number of positions
+// @param seed - selects the gradients used
+///
+void noise2Batch(const float *x, const float *y, float *out, int n,
+    unsigned int seed);
+
+///
+// noise2Accumulate - adds a scaled octave of noise to n values;
+// out[i] += amplitude * noise2(x[i] * frequency, y[i] * frequency, seed)
+//
+// @param x, y - the positions being sampled
+// @param out - the values the octave is added to
+// @param n - the number of positions
+// @param seed - selects the gradients used
+// @param frequency - scale applied to the positions
+// @param amplitude - scale applied to the noise
+///
+void noise2Accumulate(const float *x, const float *y, float *out, int n,
+    unsigned int seed, float frequency, float amplitude);
+
+///
+// fbm2 - scalar reference fractal Brownian motion; the sum of a number of
+// octaves of noise2(), normalized to the range of a single octave
+//
+// @param x, y - the position being sampled
+// @param seed - selects the gradients used
+// @param octaves - the number of octaves summed
+// @param lacunarity - how much the frequency grows each octave
+// @param gain - how much the amplitude shrinks each octave
+//
+// @return The fBm value at (x, y)
+///
+float fbm2(float x, float y, unsigned int seed, int octaves,
+    float lacunarity, float gain);
+
+///
+// fbm2Batch - evaluates fbm2() at n positions using NOISE_OCTAVES,
+// NOISE_LACUNARITY and NOISE_GAIN
+//
+// @param x, y - the positions being sampled
+// @param out - the array the n values are written to
+// @param n - the number of positions
+// @param seed - selects the gradients used
+///
+void fbm2Batch(const float *x, const float *y, float *out, int n,
+    unsigned int seed);
+
+///
+// NOISE_DEFINE_FBM - defines a static batch fBm function with a fixed number
+// of octaves, lacunarity and gain, so the octave loop and all of its
+// constants are resolved at compile time. The function has the same
+// signature and results as fbm2Batch():
+//
+//     NOISE_DEFINE_FBM(terrainFbm, 6, 2.0f, 0.5f)
+//     ...
+//     terrainFbm(x, y, out, n, seed);
+///
+#define NOISE_DEFINE_FBM(name, octaves, lacunarity, gain)                     \
+static void name(const float *x, const float *y, float *out, int n,           \
+    unsigned int seed)                                                        \
+{                                                                             \
+    float total = 0.0f;                                                       \
+    float frequency = 1.0f;                                                   \
+    float amplitude = 1.0f;                                                   \
+                                                                              \
+    for(int o = 0; o < (octaves); o++)                                        \
+    {                                                                         \
+        total += amplitude;                                                   \
+        amplitude *= (gain);                                                  \
+    }                                                                         \
+                                                                              \
+    for(int i = 0; i < n; i++)                                                \
+    {                                                                         \
+        out[i] = 0.0f;                                                        \
+    }                                                                         \
+                                                                              \
+    amplitude = 1.0f;                                                         \
+    for(int o = 0; o < (octaves); o++)                                        \
+    {                                                                         \
+        noise2Accumulate(x, y, out, n, seed + (unsigned int)o * NOISE_OCTAVE_SEED, \
+            frequency, amplitude / total);                                    \
+        frequency *= (lacunarity);                                            \
+        amplitude *= (gain);                                                  \
+    }                                                                         \
+}
+
+#endif
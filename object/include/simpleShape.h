@@ -1,7 +1,7 @@
 ///
 // simpleShape.h
 //
-// Header file for functions that manage the current shape 
+// Header file for functions that manage the current shape
 // being defined (including the addTriangles() function.
 //
 // @author T. Wilgenbusch
@@ -16,6 +16,163 @@
 #include <GL/gl.h>
 #endif
 
+#include "floatVector.h"
+#include "indexVector.h"
+
+///
+// ShapeBuilder - a mesh being built; every builder is independent, so
+// separate threads may each build a mesh with their own builder
+//
+// floatVector_t points   - the vertex positions (4 floats each)
+// floatVector_t normals  - the vertex normals (3 floats each)
+// floatVector_t uv       - the vertex texture coords (2 floats each)
+// indexVector_t indices  - the indices of indexed triangles
+// unsigned int maxIndex  - the largest of the indices
+// *Array                 - the 16 bit element arrays last handed out
+// void *elementArray     - the element array last handed out by 
+//                          shapeElementArray(), if it had to be made
+///
+typedef struct ShapeBuilder_s
+{
+    floatVector_t points;
+    floatVector_t normals;
+    floatVector_t uv;
+    indexVector_t indices;
+    unsigned int maxIndex;
+    GLushort *elemArray;
+    GLushort *indexArray;
+    void *elementArray;
+} ShapeBuilder;
+
+///
+// ShapeView - a borrowed view of the floats of one part of a shape; it 
+// points into the builder and stays valid until the builder is changed, 
+// cleared or destroyed
+//
+// const float *data - the first float
+// int count         - the number of floats
+///
+typedef struct ShapeView_s
+{
+    const float *data;
+    int count;
+} ShapeView;
+
+///
+// IndexView - a borrowed view of the indices of a shape, with the same 
+// lifetime as a ShapeView
+//
+// const unsigned int *data - the first index
+// int count                - the number of indices
+///
+typedef struct IndexView_s
+{
+    const unsigned int *data;
+    int count;
+} IndexView;
+
+///
+// ElementArray - the indices of a shape laid out for an OpenGL element 
+// array, in the narrowest type that holds every index; it has the same 
+// lifetime as a ShapeView
+//
+// const void *data - the first index
+// int count        - the number of indices
+// GLenum type      - GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+// int size         - the size of the array in bytes
+///
+typedef struct ElementArray_s
+{
+    const void *data;
+    int count;
+    GLenum type;
+    int size;
+} ElementArray;
+
+// Allocates an empty builder
+ShapeBuilder *makeShapeBuilder();
+
+// Deallocates a builder and everything in it
+void destroyShapeBuilder(ShapeBuilder *shape);
+
+void shapeClear (ShapeBuilder *shape);
+
+// Clears a builder and has it build the next shape straight into dest, 
+// laid out as all of the points (4 floats each), then all of the normals 
+// (3 floats each), then all of the tex coords (2 floats each) of exactly 
+// `vertices` vertices; dest may be a mapped OpenGL buffer
+void shapeBuildInto (ShapeBuilder *shape, float *dest, int vertices);
+
+// Makes room for a number of vertices and indices in a builder
+void shapeReserve (ShapeBuilder *shape, int vertices, int indices);
+
+int shapeAddVertex(ShapeBuilder *shape, float x, float y, float z,
+    float nx, float ny, float nz, float u, float v);
+
+void shapeAddIndexedTriangle(ShapeBuilder *shape, int i0, int i1, int i2);
+
+void shapeAddTriangle(ShapeBuilder *shape,
+    float x0, float y0, float z0,
+    float x1, float y1, float z1,
+    float x2, float y2, float z2 );
+
+void shapeAddTriangleVertices(ShapeBuilder *shape,
+    float x0, float y0, float z0,
+    float x1, float y1, float z1,
+    float x2, float y2, float z2 );
+
+void shapeAddTriangleWithNorms(ShapeBuilder *shape,
+    float x0, float y0, float z0,
+    float x1, float y1, float z1,
+    float x2, float y2, float z2,
+    float nx0, float ny0, float nz0,
+    float nx1, float ny1, float nz1,
+    float nx2, float ny2, float nz2 );
+
+void shapeAddTriangleWithTexCoords(ShapeBuilder *shape,
+                  float x0, float y0, float z0, float u0, float v0,
+                  float x1, float y1, float z1, float u1, float v1,
+                  float x2, float y2, float z2, float u2, float v2);
+
+GLushort *shapeGetElements (ShapeBuilder *shape);
+GLushort *shapeGetIndices (ShapeBuilder *shape);
+
+// Borrowed views of the data in a builder; nothing is copied
+ShapeView shapeVertexView (const ShapeBuilder *shape);
+ShapeView shapeNormalView (const ShapeBuilder *shape);
+ShapeView shapeUVView (const ShapeBuilder *shape);
+IndexView shapeIndexView (const ShapeBuilder *shape);
+
+// The type of the indices of a shape's element array: 16 bit unless some 
+// index does not fit
+GLenum shapeIndexType (const ShapeBuilder *shape);
+
+// The element array of a shape: its indices if it has any, or else one 
+// element per vertex; only copied if the indices are narrowed to 16 bits
+ElementArray shapeElementArray (ShapeBuilder *shape);
+
+// Reorders the indexed triangles of a shape for the GPU's vertex cache, and
+// gets the average number of vertices transformed per triangle on a FIFO
+// cache of cacheSize entries
+void shapeOptimizeVertexCache (ShapeBuilder *shape);
+float shapeACMR (const ShapeBuilder *shape, int cacheSize);
+
+// Borrowed pointers to the data in a builder; nothing is copied
+float *shapeGetVertices (ShapeBuilder *shape);
+float *shapeGetNormals (ShapeBuilder *shape);
+float *shapeGetUV (ShapeBuilder *shape);
+
+int shapeVertices (const ShapeBuilder *shape);
+int shapeIndices (const ShapeBuilder *shape);
+
+///
+// The original interface; these work on a single default builder and so
+// may only be used from one thread at a time
+///
+
+// Gets the builder used by the functions below
+ShapeBuilder *defaultShapeBuilder ();
+
 void clearShape ();
 
 
@@ -24,7 +181,7 @@ void addTriangle(
     float x1, float y1, float z1,
     float x2, float y2, float z2 );
 
-void addTriangleVertices(    
+void addTriangleVertices(
     float x0, float y0, float z0,
     float x1, float y1, float z1,
     float x2, float y2, float z2 );
@@ -37,17 +194,24 @@ void addTriangleWithNorms(
     float nx1, float ny1, float nz1,
     float nx2, float ny2, float nz2 );
 
-void addTriangleWithTexCoords (float x0, float y0, float z0, float u0, float v0, 
-                  float x1, float y1, float z1, float u1, float v1, 
+void addTriangleWithTexCoords (float x0, float y0, float z0, float u0, float v0,
+                  float x1, float y1, float z1, float u1, float v1,
                   float x2, float y2, float z2, float u2, float v2);
 
+int addVertex(float x, float y, float z, float nx, float ny, float nz,
+    float u, float v);
+
+void addIndexedTriangle(int i0, int i1, int i2);
+
 
 GLushort *getElements ();
+GLushort *getIndices ();
 
 float *getVertices ();
 float *getNormals ();
 float *getUV();
 
 int nVertices ();
+int nIndices ();
 
 #endif
@@ -0,0 +1,89 @@
+///
+// terrainVertex.h
+//
+// The compact vertex format of terrain meshes. The grid position of a 
+// vertex is the same in every chunk, so it is kept in a TerrainGridPoint 
+// shared by all chunks; each chunk only has a TerrainVertex of 8 bytes per 
+// point: its height and morph height as 16 bit integers, and its normal 
+// octahedral-encoded into two bytes. Texture coords are not stored; the 
+// vertex shader derives them from the position.
+//
+// @author T. Wilgenbusch
+///
+
+#ifndef _TERRAINVERTEX_H_
+#define _TERRAINVERTEX_H_
+
+#ifdef __APPLE__
+#include <OpenGL/gl.h>
+#else
+#include <GL/gl.h>
+#endif
+
+///
+// TerrainGridPoint - the position of a vertex in its chunk's grid
+//
+// GLshort x - the column of the vertex
+// GLshort z - the row of the vertex
+///
+typedef struct TerrainGridPoint_s
+{
+    GLshort x;
+    GLshort z;
+} TerrainGridPoint;
+
+///
+// TerrainVertex - the part of a packed terrain vertex that differs between 
+// chunks
+//
+// GLshort height   - the height of the vertex, in steps of 
+//                    1/HEIGHT_PRECISION
+// GLshort morph    - the height the vertex morphs to as it blends into 
+//                    the next coarser level of detail
+// GLbyte normal[2] - the octahedral encoding of the vertex's normal, read 
+//                    by OpenGL as normalized bytes
+// GLbyte pad[2]    - keeps every vertex 4 byte aligned
+///
+typedef struct TerrainVertex_s
+{
+    GLshort height;
+    GLshort morph;
+    GLbyte normal[2];
+    GLbyte pad[2];
+} TerrainVertex;
+
+// Byte offsets of the attributes of a TerrainVertex
+#define TERRAIN_HEIGHT_OFFSET 0
+#define TERRAIN_NORMAL_OFFSET (2 * sizeof(GLshort))
+
+///
+// packTerrainVertex - packs a vertex of a chunk's grid
+//
+// @param height - the height of the vertex, in steps of 1/HEIGHT_PRECISION
+// @param morph - the height the vertex morphs to, in the same steps
+// @param nx, ny, nz - the normal of the vertex; need not be normalized
+//
+// @return The packed vertex
+///
+TerrainVertex packTerrainVertex(int height, int morph,
+    float nx, float ny, float nz);
+
+///
+// encodeOctahedral - encodes a normal as a point on an octahedron, folded 
+// out into a square of two bytes
+//
+// @param nx, ny, nz - the normal; need not be normalized
+// @param out - the two encoded bytes
+///
+void encodeOctahedral(float nx, float ny, float nz, GLbyte out[2]);
+
+///
+// decodeOctahedral - the inverse of encodeOctahedral(), as done in the 
+// vertex shader
+//
+// @param in - the two encoded bytes
+// @param n - the decoded unit normal
+///
+void decodeOctahedral(const GLbyte in[2], float n[3]);
+
+#endif
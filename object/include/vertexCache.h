@@ -0,0 +1,33 @@
+///
+// vertexCache.h
+//
+// Reordering of indexed triangle meshes for the GPU's post-transform vertex
+// cache and for vertex fetch, and a simulation of the cache to measure them.
+//
+// @author T. Wilgenbusch
+///
+
+#ifndef _VERTEXCACHE_H_
+#define _VERTEXCACHE_H_
+
+// The number of entries of the FIFO cache simulated by vertexCacheACMR();
+// about what current GPUs keep of transformed vertices
+#define VERTEX_CACHE_SIZE 16
+
+// Reorders the triangles of a mesh so that they reuse the vertices of the
+// triangles just before them
+void optimizeVertexCache(unsigned int *indices, int indexCount,
+    int vertexCount);
+
+// Renumbers the vertices of a mesh in the order the triangles first use them;
+// fills remap with the new number of every old vertex and returns how many
+// vertices are used
+int optimizeVertexFetch(unsigned int *indices, int indexCount,
+    int vertexCount, unsigned int *remap);
+
+// The average number of vertices transformed per triangle of a mesh, on a
+// FIFO cache of cacheSize entries
+float vertexCacheACMR(const unsigned int *indices, int indexCount,
+    int vertexCount, int cacheSize);
+
+#endif
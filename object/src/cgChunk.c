@@ -10,11 +10,24 @@
 
 #include "cgChunk.h"
 #include "simpleShape.h"
+#include "noise.h"
+#include "chunkRandom.h"
+#include "vertexCache.h"
 
 #ifdef __cplusplus
 #include <cmath>
+#include <cfloat>
+#include <cstring>
 #else
 #include <math.h>
+#include <float.h>
+#include <string.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
 #endif
 
 
@@ -30,100 +43,525 @@
 // Definition of PI
 #define PI 3.14159265358979323846
 
+// The number of points along one side of a chunk and its apron
+#define PADDED_SIZE (CHUNK_GRID_SIZE + 2)
+#define PADDED_POINTS (PADDED_SIZE * PADDED_SIZE)
+
+// Index of the point (gx, gy) of a chunk into its padded grid; gx and gy run 
+// from -1 to CHUNK_GRID_SIZE
+#define PADDED_INDEX(gx, gy) (((gx) + 1) * PADDED_SIZE + ((gy) + 1))
+
+// The number of sampled heights along one side of a chunk. The lattice is 
+// aligned to the world, so the first sample may lie up to a whole lattice 
+// cell before the chunk's apron; the last lies on or past its far edge
+#define LATTICE_SIZE \
+    ((PADDED_SIZE + SAMPLE_SIZE * TESS_FACTOR - 2) / \
+     (SAMPLE_SIZE * TESS_FACTOR) + 2)
+
+// The frequency of the terrain noise, in cycles per square
+#define TERRAIN_FREQUENCY (1.0f / 40.0f)
+
+// The total number of tessellated points in a chunk
+#define GRID_POINTS (CHUNK_GRID_SIZE * CHUNK_GRID_SIZE)
+
+// Index of the tessellated point (gx, gy) of a chunk
+#define GRID_INDEX(gx, gy) ((gx) * CHUNK_GRID_SIZE + (gy))
+
+// The number of cells along one side of a chunk's grid
+#define GRID_CELLS (CHUNK_GRID_SIZE - 1)
+
+// The adaptive mesher splits the chunk's grid in half again and again, so 
+// the number of cells along a side has to be a power of 2
+#if (GRID_CELLS & (GRID_CELLS - 1)) != 0
+#error "CHUNK_SIZE * TESS_FACTOR must be a power of 2"
+#endif
+
+// The number of triangles in the error hierarchy of a chunk (every triangle 
+// of the hierarchy with a point at the middle of its hypotenuse), and the 
+// number of those that have children with such a point as well
+#define RTIN_TRIANGLES (GRID_CELLS * GRID_CELLS * 2 - 2)
+#define RTIN_PARENTS (RTIN_TRIANGLES - GRID_CELLS * GRID_CELLS)
+
 ///
-// makeSquare - allocates space for a square structure with default values
+// makeChunk - allocates space for a Chunk structure with default values
 //
-// @return A pointer to the generated square
+// All of the squares are stored inside of the chunk, so this is the only 
+// allocation made for a chunk
+//
+// @param coordX, coordY - the coordinates of the chunk in the grid of chunks
+//
+// @return A pointer to the generated Chunk
 ///
-Square *makeSquare()
+Chunk *makeChunk(int coordX, int coordY)
 {
-    Square *result = (Square *)malloc(sizeof(Square));
-    result->x = 0.0f;
-    result->y = 0.0f;
-    result->z = 0.0f;
-    result->texId = 0;
+    Chunk *result = (Chunk *)malloc(sizeof(Chunk));
+    result->coord.x = coordX;
+    result->coord.y = coordY;
+    result->chunkX = (GLfloat)(coordX * CHUNK_SIZE);
+    result->chunkY = (GLfloat)(coordY * CHUNK_SIZE);
+
+    result->rotate[0] = 0.0f;
+    result->rotate[1] = 0.0f;
+    result->rotate[2] = 0.0f;
+    
+    result->scale[0] = 1.0f;
+    result->scale[1] = 1.0f;
+    result->scale[2] = 1.0f;
+
+    for(int i = 0; i < CHUNK_SQUARES; i++)
+    {
+        result->z[i] = 0.0f;
+        result->texId[i] = 0;
+        result->finished[i] = false;
+    }
 
-    for(int x = 0; x < NUM_POINTS; x++)
+    for(int p = 0; p < NUM_POINTS; p++)
     {
-        result->points[x] = 0.0f;
+        for(int i = 0; i < CHUNK_SQUARES; i++)
+        {
+            result->points[p][i] = 0.0f;
+        }
     }
 
-    result->finished = false;
+    for(int side = 0; side < 4; side++)
+    {
+        for(int g = 0; g < CHUNK_GRID_SIZE; g++)
+        {
+            result->apron[side][g] = 0.0f;
+        }
+    }
+
+    for(int p = 0; p < CHUNK_GRID_SIZE * CHUNK_GRID_SIZE; p++)
+    {
+        result->errors[p] = 0.0f;
+    }
 
     return result;
 }
 
 ///
-// destroySquare - deallocates memory for the given square
+// destroyChunk - deallocates memory for the given Chunk
 //
-// @param square - the sqaure to destroy
+// @param chunk - the chunk to destroy
 ///
-void destroySquare(Square *square)
+void destroyChunk(Chunk *chunk)
 {
-    if(square)
+    if(chunk)
     {
-        free(square);
+        free(chunk);
     }
 }
 
 ///
-// makeChunk - allocates space for a Chunk structure with default values
+// getSquare - copies the fields of a single square out of a chunk
 //
-// @return A pointer to the generated Chunk
+// @param chunk - the chunk holding the square
+// @param x, y - the coordinates of the square inside of the chunk
+//
+// @return A copy of the square at (x, y)
 ///
-Chunk *makeChunk()
+Square getSquare(const Chunk *chunk, int x, int y)
 {
-    Chunk *result = (Chunk *)malloc(sizeof(Chunk));
-    result->chunkX = 0.0f;
-    result->chunkY = 0.0f;
+    Square result;
+    int index = SQUARE_INDEX(x, y);
 
-    result->rotate[0] = -90.0f;
-    result->rotate[1] = 0.0f;
-    result->rotate[2] = 0.0f;
-    
-    result->scale[0] = 1.0f;
-    result->scale[1] = 1.0f;
-    result->scale[2] = 1.0f;
+    result.x = (GLfloat)x;
+    result.y = (GLfloat)y;
+    result.z = chunk->z[index];
+    result.texId = chunk->texId[index];
+    result.finished = chunk->finished[index];
 
-    for(int x = 0; x < CHUNK_SIZE; x++)
+    for(int p = 0; p < NUM_POINTS; p++)
     {
-        for(int y = 0; y < CHUNK_SIZE; y++)
+        result.points[p] = chunk->points[p][index];
+    }
+
+    return result;
+}
+
+///
+// setSquare - writes the fields of a single square back into a chunk; the 
+// square's own x, y are ignored in favour of the given coordinates
+//
+// @param chunk - the chunk holding the square
+// @param x, y - the coordinates of the square inside of the chunk
+// @param square - the values to store
+///
+void setSquare(Chunk *chunk, int x, int y, const Square *square)
+{
+    int index = SQUARE_INDEX(x, y);
+
+    chunk->z[index] = square->z;
+    chunk->texId[index] = square->texId;
+    chunk->finished[index] = square->finished;
+
+    for(int p = 0; p < NUM_POINTS; p++)
+    {
+        chunk->points[p][index] = square->points[p];
+    }
+}
+
+
+// The noise the sampled heights are taken from; octaves finer than the 
+// sample lattice would only alias, so only a few are used
+NOISE_DEFINE_FBM(terrainFbm, 3, 2.0f, 0.5f)
+
+///
+// floorDiv - integer division rounding towards negative infinity, so that 
+// chunks with negative coordinates land on the same lattice
+///
+static int floorDiv(int a, int b)
+{
+    int q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+///
+// quantizeHeight - rounds a height onto the multiples of 1/HEIGHT_PRECISION
+///
+static float quantizeHeight(float height)
+{
+    return floorf(height * HEIGHT_PRECISION + 0.5f) / HEIGHT_PRECISION;
+}
+
+///
+// interpolateHeights - bilinearly interpolates the sampled heights at a batch
+// of positions
+//
+// @param samples - the LATTICE_SIZE x LATTICE_SIZE sampled heights
+// @param cell - the index into samples of the lower corner of the lattice 
+//               cell holding each position
+// @param fu, fv - the position of each point inside of its cell (0 to 1)
+// @param out - the array the interpolated heights are written to
+// @param n - the number of positions
+///
+static void interpolateHeights(const float *samples, const int *cell, 
+    const float *fu, const float *fv, float *out, int n)
+{
+    int i = 0;
+
+#ifdef __AVX2__
+    const __m256i stride = _mm256_set1_epi32(LATTICE_SIZE);
+    const __m256i one = _mm256_set1_epi32(1);
+
+    // Interpolate 8 positions at a time, gathering the 4 surrounding samples 
+    // of every lane
+    for(; i + 8 <= n; i += 8)
+    {
+        __m256 pu = _mm256_loadu_ps(fu + i);
+        __m256 pv = _mm256_loadu_ps(fv + i);
+
+        __m256i i00 = _mm256_loadu_si256((const __m256i *)(cell + i));
+        __m256i i01 = _mm256_add_epi32(i00, one);
+        __m256i i10 = _mm256_add_epi32(i00, stride);
+        __m256i i11 = _mm256_add_epi32(i10, one);
+
+        __m256 s00 = _mm256_i32gather_ps(samples, i00, 4);
+        __m256 s01 = _mm256_i32gather_ps(samples, i01, 4);
+        __m256 s10 = _mm256_i32gather_ps(samples, i10, 4);
+        __m256 s11 = _mm256_i32gather_ps(samples, i11, 4);
+
+        __m256 a = _mm256_add_ps(s00, _mm256_mul_ps(_mm256_sub_ps(s01, s00), pv));
+        __m256 b = _mm256_add_ps(s10, _mm256_mul_ps(_mm256_sub_ps(s11, s10), pv));
+        __m256 r = _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), pu));
+
+        _mm256_storeu_ps(out + i, r);
+    }
+#endif
+
+    // Scalar path; also handles whatever is left over from the vector loop
+    for(; i < n; i++)
+    {
+        float s00 = samples[cell[i]];
+        float s01 = samples[cell[i] + 1];
+        float s10 = samples[cell[i] + LATTICE_SIZE];
+        float s11 = samples[cell[i] + LATTICE_SIZE + 1];
+
+        float a = s00 + (s01 - s00) * fv[i];
+        float b = s10 + (s11 - s10) * fv[i];
+        out[i] = a + (b - a) * fu[i];
+    }
+}
+
+///
+// matchNeighbours - copies the points a chunk shares with each of its 
+// already generated neighbours out of that neighbour
+//
+// @param chunk - the chunk being generated
+// @param registry - the registry holding the generated chunks
+// @param heights - the final height of every point in the chunk
+///
+static void matchNeighbours(const Chunk *chunk, ChunkMap registry, 
+    float *heights)
+{
+    const int last = CHUNK_GRID_SIZE - 1;
+    Chunk *neighbour;
+
+    // Other threads may be adding and removing chunks; keep the neighbours 
+    // from being freed while they are read
+    int pin = chunkMapPin(registry);
+
+    // West and east share a column of points
+    neighbour = findChunk(registry, chunk->coord.x - 1, chunk->coord.y);
+    if(neighbour != NULL)
+    {
+        for(int g = 0; g < CHUNK_GRID_SIZE; g++)
         {
-            result->squares[x][y] = makeSquare();
-            result->squares[x][y]->x = (float)x;
-            result->squares[x][y]->y = (float)y;
-            printf("%lu\n", (long unsigned)result->squares[x][y]);
+            heights[GRID_INDEX(0, g)] = getPointHeight(neighbour, last, g);
         }
     }
 
+    neighbour = findChunk(registry, chunk->coord.x + 1, chunk->coord.y);
+    if(neighbour != NULL)
+    {
+        for(int g = 0; g < CHUNK_GRID_SIZE; g++)
+        {
+            heights[GRID_INDEX(last, g)] = getPointHeight(neighbour, 0, g);
+        }
+    }
 
-    return result;
+    // South and north share a row of points
+    neighbour = findChunk(registry, chunk->coord.x, chunk->coord.y - 1);
+    if(neighbour != NULL)
+    {
+        for(int g = 0; g < CHUNK_GRID_SIZE; g++)
+        {
+            heights[GRID_INDEX(g, 0)] = getPointHeight(neighbour, g, last);
+        }
+    }
+
+    neighbour = findChunk(registry, chunk->coord.x, chunk->coord.y + 1);
+    if(neighbour != NULL)
+    {
+        for(int g = 0; g < CHUNK_GRID_SIZE; g++)
+        {
+            heights[GRID_INDEX(g, last)] = getPointHeight(neighbour, g, 0);
+        }
+    }
+
+    chunkMapUnpin(registry, pin);
 }
 
 ///
-// destroyChunk - deallocates memory for the given Chunk
+// generateChunk - generates the heights of every square in a chunk
+//
+// Heights are sampled from fractal noise on a lattice every SAMPLE_SIZE 
+// squares of the world, and the heights of all the tessellated points in 
+// between are interpolated from that lattice in a single batch. Each square's 
+// z is the interpolated height of its corner, and each of its points gets a 
+// small random variance on top of the interpolated height. Points shared by 
+// neighbouring squares are only generated once, so the squares line up.
+//
+// No generator state is shared between chunks: the noise seed comes from the 
+// world seed, and each point's variance is keyed on the world seed and the 
+// point's coordinates in the world. A chunk therefore comes out identical 
+// whichever thread generates it and in whatever order chunks are generated.
 //
-// @param chunk - the sqaure to destroy
+// The lattice is aligned to the world rather than to the chunk, and a point's 
+// place in the lattice is worked out with integer math, so a point on the 
+// border of two chunks gets the same height from both. Any neighbours already 
+// in the registry have their shared border copied over as well. The apron of 
+// points just past each side is generated the same way, so it holds exactly 
+// the heights the neighbouring chunks will have there.
+//
+// @param chunk - the chunk being generated
+// @param worldSeed - the seed of the world the chunk is in
+// @param registry - the chunks generated so far (may be NULL)
 ///
-void destroyChunk(Chunk *chunk)
+void generateChunk(Chunk *chunk, uint64_t worldSeed, ChunkMap registry)
 {
-    if(chunk)
+    const int spacing = SAMPLE_SIZE * TESS_FACTOR;
+    unsigned int noiseSeed = (unsigned int)randomMix(worldSeed);
+
+    // The world coordinates of the chunk's first point and lattice sample
+    int originX = chunk->coord.x * CHUNK_SIZE * TESS_FACTOR;
+    int originY = chunk->coord.y * CHUNK_SIZE * TESS_FACTOR;
+    int latticeX = floorDiv(originX - 1, spacing);
+    int latticeY = floorDiv(originY - 1, spacing);
+
+    float sampleX[LATTICE_SIZE * LATTICE_SIZE];
+    float sampleY[LATTICE_SIZE * LATTICE_SIZE];
+    float samples[LATTICE_SIZE * LATTICE_SIZE];
+    int cell[PADDED_POINTS];
+    float fu[PADDED_POINTS], fv[PADDED_POINTS];
+    float padded[PADDED_POINTS];
+    float heights[GRID_POINTS];
+
+    // Sample the noise at the world position of every lattice point
+    for(int lu = 0; lu < LATTICE_SIZE; lu++)
+    {
+        for(int lv = 0; lv < LATTICE_SIZE; lv++)
+        {
+            int i = lu * LATTICE_SIZE + lv;
+            sampleX[i] = (float)((latticeX + lu) * SAMPLE_SIZE) * TERRAIN_FREQUENCY;
+            sampleY[i] = (float)((latticeY + lv) * SAMPLE_SIZE) * TERRAIN_FREQUENCY;
+        }
+    }
+
+    terrainFbm(sampleX, sampleY, samples, LATTICE_SIZE * LATTICE_SIZE, 
+        noiseSeed);
+
+    // Map the noise (roughly -1 to 1) onto the range of heights
+    for(int i = 0; i < LATTICE_SIZE * LATTICE_SIZE; i++)
+    {
+        samples[i] = MIN_HEIGHT + 
+            (MAX_HEIGHT - MIN_HEIGHT) * (samples[i] + 1.0f) * 0.5f;
+    }
+
+    // The lattice cell of every tessellated point (apron included) and its 
+    // place in that cell
+    for(int gx = -1; gx <= CHUNK_GRID_SIZE; gx++)
+    {
+        int px = originX + gx;
+        int cu = floorDiv(px, spacing);
+
+        for(int gy = -1; gy <= CHUNK_GRID_SIZE; gy++)
+        {
+            int py = originY + gy;
+            int cv = floorDiv(py, spacing);
+            int g = PADDED_INDEX(gx, gy);
+
+            cell[g] = (cu - latticeX) * LATTICE_SIZE + (cv - latticeY);
+            fu[g] = (float)(px - cu * spacing) / (float)spacing;
+            fv[g] = (float)(py - cv * spacing) / (float)spacing;
+        }
+    }
+
+    interpolateHeights(samples, cell, fu, fv, padded, PADDED_POINTS);
+
+    // Split the heights into each square's base z and per point variance
+    for(int x = 0; x < CHUNK_SIZE; x++)
+    {
+        for(int y = 0; y < CHUNK_SIZE; y++)
+        {
+            int index = SQUARE_INDEX(x, y);
+            chunk->z[index] = quantizeHeight(
+                padded[PADDED_INDEX(x * TESS_FACTOR, y * TESS_FACTOR)]);
+        }
+    }
+
+    for(int gx = -1; gx <= CHUNK_GRID_SIZE; gx++)
+    {
+        for(int gy = -1; gy <= CHUNK_GRID_SIZE; gy++)
+        {
+            int g = PADDED_INDEX(gx, gy);
+            padded[g] = quantizeHeight(padded[g] + randomRangeAt(
+                randomKey(worldSeed, originX + gx, originY + gy), 0, 
+                MIN_VAR, MAX_VAR));
+        }
+    }
+
+    for(int gx = 0; gx < CHUNK_GRID_SIZE; gx++)
+    {
+        for(int gy = 0; gy < CHUNK_GRID_SIZE; gy++)
+        {
+            heights[GRID_INDEX(gx, gy)] = padded[PADDED_INDEX(gx, gy)];
+        }
+    }
+
+    for(int g = 0; g < CHUNK_GRID_SIZE; g++)
+    {
+        chunk->apron[APRON_WEST][g] = padded[PADDED_INDEX(-1, g)];
+        chunk->apron[APRON_EAST][g] = padded[PADDED_INDEX(CHUNK_GRID_SIZE, g)];
+        chunk->apron[APRON_SOUTH][g] = padded[PADDED_INDEX(g, -1)];
+        chunk->apron[APRON_NORTH][g] = padded[PADDED_INDEX(g, CHUNK_GRID_SIZE)];
+    }
+
+    if(registry != NULL)
+    {
+        matchNeighbours(chunk, registry, heights);
+    }
+
+    for(int x = 0; x < CHUNK_SIZE; x++)
     {
-        for(int x = 0; x < CHUNK_SIZE; x++)
+        for(int y = 0; y < CHUNK_SIZE; y++)
         {
-            for(int y = 0; y < CHUNK_SIZE; y++)
+            int index = SQUARE_INDEX(x, y);
+            float base = chunk->z[index];
+
+            for(int i = 0; i <= TESS_FACTOR; i++)
             {
-                if(chunk->squares[x][y])
+                for(int j = 0; j <= TESS_FACTOR; j++)
                 {
-                    destroySquare(chunk->squares[x][y]);
+                    int g = GRID_INDEX(x * TESS_FACTOR + i, y * TESS_FACTOR + j);
+                    chunk->points[POINT_INDEX(i, j)][index] = heights[g] - base;
                 }
             }
+
+            chunk->finished[index] = true;
         }
+    }
 
-        free(chunk);
+    computeChunkErrors(chunk);
+}
+
+///
+// getPointHeight - the height of a tessellated point of a chunk
+//
+// Points on the edges of squares belong to more than one square; because 
+// heights are quantized, every square holding the point gives the same value
+//
+// @param chunk - the chunk holding the point
+// @param gx, gy - the coordinates of the point, from 0 to CHUNK_GRID_SIZE - 1
+//
+// @return The height of the point
+///
+GLfloat getPointHeight(const Chunk *chunk, int gx, int gy)
+{
+    int x = gx / TESS_FACTOR;
+    int y = gy / TESS_FACTOR;
+
+    // The last row and column of points only belong to the last squares
+    if(x == CHUNK_SIZE)
+    {
+        x -= 1;
+    }
+    if(y == CHUNK_SIZE)
+    {
+        y -= 1;
     }
+
+    int index = SQUARE_INDEX(x, y);
+    int p = POINT_INDEX(gx - x * TESS_FACTOR, gy - y * TESS_FACTOR);
+    return chunk->z[index] + chunk->points[p][index];
 }
 
+///
+// makeChunkRegistry - creates an empty registry of chunks, keyed by their 
+// coordinates; chunks may be looked up by any thread while others add them
+//
+// @return The new registry; free it with destroyChunkMap() (the chunks are 
+//         not freed)
+///
+ChunkMap makeChunkRegistry()
+{
+    return makeChunkMap(NULL);
+}
+
+///
+// registerChunk - adds a chunk to a registry under its own coordinates
+//
+// @param registry - the registry being updated
+// @param chunk - the chunk being added
+///
+void registerChunk(ChunkMap registry, Chunk *chunk)
+{
+    chunkMapPut(registry, chunk->coord.x, chunk->coord.y, chunk);
+}
+
+///
+// findChunk - looks up the chunk at (x, y) in a registry; the caller must 
+// have the registry pinned with chunkMapPin() for as long as it uses the chunk
+//
+// @param registry - the registry being searched
+// @param x, y - the coordinates of the chunk
+//
+// @return The chunk, or NULL if it is not in the registry
+///
+Chunk *findChunk(ChunkMap registry, int x, int y)
+{
+    return (Chunk *)chunkMapGet(registry, x, y);
+}
 
 ///
 // getPointsFromCenter - given a point on the TOP face of a Square, calculates all
@@ -261,3 +699,581 @@ void makeDefaultSquare()
     generateSquare(TESS_FACTOR);
 }
 
+///
+// makeChunkSquare - creates the tessellated square at (x, y) in a chunk, 
+// raising each of its points by that point's variance
+//
+// The square's y runs along the negative y axis of the unit square, so that 
+// it lines up with the rest of the chunk once it has been rotated into place
+//
+// @param chunk - the chunk holding the square
+// @param x, y - the coordinates of the square inside of the chunk
+///
+void makeChunkSquare(const Chunk *chunk, int x, int y)
+{
+    int index = SQUARE_INDEX(x, y);
+    float sideLength = UNIT_WIDTH / (float)TESS_FACTOR;
+
+    float allPx[TOTAL_POINTS] = { 0.0f };
+    float allPy[TOTAL_POINTS] = { 0.0f };
+    float allPz[TOTAL_POINTS] = { 0.0f };
+
+    for(int i = 0; i < TESS_FACTOR; i++)
+    {
+        for(int j = 0; j < TESS_FACTOR; j++)
+        {
+            float left = UNIT_MIN + i * sideLength;
+            float top = UNIT_MAX - j * sideLength;
+
+            // Corners in the order used by addSubDivision()
+            allPx[0] = left;              allPy[0] = top;
+            allPx[1] = left + sideLength; allPy[1] = top;
+            allPx[2] = left;              allPy[2] = top - sideLength;
+            allPx[3] = left + sideLength; allPy[3] = top - sideLength;
+
+            allPz[0] = UNIT_MAX + chunk->points[POINT_INDEX(i, j)][index];
+            allPz[1] = UNIT_MAX + chunk->points[POINT_INDEX(i + 1, j)][index];
+            allPz[2] = UNIT_MAX + chunk->points[POINT_INDEX(i, j + 1)][index];
+            allPz[3] = UNIT_MAX + chunk->points[POINT_INDEX(i + 1, j + 1)][index];
+
+            addSubDivision(allPx, allPy, allPz);
+        }
+    }
+}
+
+///
+// gridNormals - derives the unit normal of every point of a chunk from 
+// central differences of the heights around it
+//
+// Each row of points is processed 8 (AVX2) or 4 (SSE2) at a time; the 
+// scalar path does the same operations in the same order, so every path 
+// gives identical normals.
+//
+// @param padded - the heights of the chunk and its apron, indexed with 
+//        PADDED_INDEX()
+// @param nx, ny, nz - the GRID_POINTS normals, indexed with GRID_INDEX()
+///
+static void gridNormals(const float *padded, float *nx, float *ny, float *nz)
+{
+    // The normal of the surface is (h(x-1) - h(x+1), 2 * step, 
+    // h(z-1) - h(z+1)) before it is normalized
+    const float up = 2.0f * UNIT_WIDTH / (float)TESS_FACTOR;
+    const float up2 = up * up;
+
+    for(int gx = 0; gx < CHUNK_GRID_SIZE; gx++)
+    {
+        const float *west = padded + PADDED_INDEX(gx - 1, 0);
+        const float *east = padded + PADDED_INDEX(gx + 1, 0);
+        const float *row = padded + PADDED_INDEX(gx, 0);
+        float *outX = nx + GRID_INDEX(gx, 0);
+        float *outY = ny + GRID_INDEX(gx, 0);
+        float *outZ = nz + GRID_INDEX(gx, 0);
+        int gy = 0;
+
+#if defined(__AVX2__)
+        const __m256 vUp = _mm256_set1_ps(up);
+        const __m256 vUp2 = _mm256_set1_ps(up2);
+
+        for(; gy + 8 <= CHUNK_GRID_SIZE; gy += 8)
+        {
+            __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(west + gy), 
+                _mm256_loadu_ps(east + gy));
+            __m256 dz = _mm256_sub_ps(_mm256_loadu_ps(row + gy - 1), 
+                _mm256_loadu_ps(row + gy + 1));
+            __m256 len = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(
+                _mm256_mul_ps(dx, dx), vUp2), _mm256_mul_ps(dz, dz)));
+
+            _mm256_storeu_ps(outX + gy, _mm256_div_ps(dx, len));
+            _mm256_storeu_ps(outY + gy, _mm256_div_ps(vUp, len));
+            _mm256_storeu_ps(outZ + gy, _mm256_div_ps(dz, len));
+        }
+#elif defined(__SSE2__)
+        const __m128 vUp = _mm_set1_ps(up);
+        const __m128 vUp2 = _mm_set1_ps(up2);
+
+        for(; gy + 4 <= CHUNK_GRID_SIZE; gy += 4)
+        {
+            __m128 dx = _mm_sub_ps(_mm_loadu_ps(west + gy), 
+                _mm_loadu_ps(east + gy));
+            __m128 dz = _mm_sub_ps(_mm_loadu_ps(row + gy - 1), 
+                _mm_loadu_ps(row + gy + 1));
+            __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(dx, dx), vUp2), _mm_mul_ps(dz, dz)));
+
+            _mm_storeu_ps(outX + gy, _mm_div_ps(dx, len));
+            _mm_storeu_ps(outY + gy, _mm_div_ps(vUp, len));
+            _mm_storeu_ps(outZ + gy, _mm_div_ps(dz, len));
+        }
+#endif
+
+        // Scalar path; also handles whatever is left over from the vector loop
+        for(; gy < CHUNK_GRID_SIZE; gy++)
+        {
+            float dx = west[gy] - east[gy];
+            float dz = row[gy - 1] - row[gy + 1];
+            float len = sqrtf(dx * dx + up2 + dz * dz);
+
+            outX[gy] = dx / len;
+            outY[gy] = up / len;
+            outZ[gy] = dz / len;
+        }
+    }
+}
+
+///
+// paddedHeights - lays out the heights of a chunk and its apron in one 
+// padded grid; the corners of the padded grid are never read
+//
+// @param chunk - the chunk
+// @param padded - the PADDED_POINTS heights, indexed with PADDED_INDEX()
+///
+static void paddedHeights(const Chunk *chunk, float *padded)
+{
+    for(int gx = 0; gx < CHUNK_GRID_SIZE; gx++)
+    {
+        for(int gy = 0; gy < CHUNK_GRID_SIZE; gy++)
+        {
+            padded[PADDED_INDEX(gx, gy)] = getPointHeight(chunk, gx, gy);
+        }
+    }
+
+    for(int g = 0; g < CHUNK_GRID_SIZE; g++)
+    {
+        padded[PADDED_INDEX(-1, g)] = chunk->apron[APRON_WEST][g];
+        padded[PADDED_INDEX(CHUNK_GRID_SIZE, g)] = chunk->apron[APRON_EAST][g];
+        padded[PADDED_INDEX(g, -1)] = chunk->apron[APRON_SOUTH][g];
+        padded[PADDED_INDEX(g, CHUNK_GRID_SIZE)] = chunk->apron[APRON_NORTH][g];
+    }
+}
+
+///
+// makeGridMesh - creates the part of a chunk's mesh that every chunk shares 
+// at a level of detail: the grid position of every 2^lod-th tessellated 
+// point, and an index buffer of two triangles per cell
+//
+// @param lod - the level of detail, from 0 (every point) to 
+//        CHUNK_LOD_LEVELS - 1
+// @param points - the CHUNK_LOD_VERTICES(lod) grid points of the mesh, 
+//        stored row by row
+// @param shape - the builder the indices are added to
+///
+void makeGridMesh(int lod, TerrainGridPoint *points, ShapeBuilder *shape)
+{
+    const int step = 1 << lod;
+    const int size = CHUNK_LOD_GRID_SIZE(lod);
+
+    shapeReserve(shape, 0, CHUNK_LOD_INDICES(lod));
+
+    for(int i = 0; i < size; i++)
+    {
+        for(int j = 0; j < size; j++)
+        {
+            points[i * size + j].x = (GLshort)(i * step);
+            points[i * size + j].z = (GLshort)(j * step);
+        }
+    }
+
+    for(int i = 0; i < size - 1; i++)
+    {
+        for(int j = 0; j < size - 1; j++)
+        {
+            int a = i * size + j;
+            int b = i * size + j + 1;
+            int c = (i + 1) * size + j + 1;
+            int d = (i + 1) * size + j;
+
+            shapeAddIndexedTriangle(shape, a, b, c);
+            shapeAddIndexedTriangle(shape, a, c, d);
+        }
+    }
+}
+
+///
+// optimizeGridMesh - reorders a grid mesh made by makeGridMesh() for the 
+// GPU: the triangles for the vertex cache, then, above level 0, the grid 
+// points in the order the triangles use them. Level 0 keeps its points in 
+// GRID_INDEX() order, since the adaptive meshes of makeChunkAdaptiveMesh() 
+// index them by grid position.
+//
+// @param lod - the level of detail of the mesh
+// @param points - the CHUNK_LOD_VERTICES(lod) grid points of the mesh
+// @param shape - the shape builder holding the indices of the mesh
+///
+void optimizeGridMesh(int lod, TerrainGridPoint *points, ShapeBuilder *shape)
+{
+    const int vertices = CHUNK_LOD_VERTICES(lod);
+    unsigned int *indices = shape->indices.vec;
+    int count = shapeIndices(shape);
+
+    shapeOptimizeVertexCache(shape);
+    if(lod == 0)
+    {
+        return;
+    }
+
+    unsigned int *remap = (unsigned int *)malloc(
+        vertices * sizeof(unsigned int));
+    TerrainGridPoint *moved = (TerrainGridPoint *)malloc(
+        vertices * sizeof(TerrainGridPoint));
+    if(remap == NULL || moved == NULL)
+    {
+        perror( "grid mesh allocation failed" );
+        exit( 1 );
+    }
+
+    // Every point of the grid is used, so the remap is a permutation
+    optimizeVertexFetch(indices, count, vertices, remap);
+    for(int v = 0; v < vertices; v++)
+    {
+        moved[remap[v]] = points[v];
+    }
+    memcpy(points, moved, vertices * sizeof(TerrainGridPoint));
+
+    free(remap);
+    free(moved);
+}
+
+///
+// makeChunkMesh - creates the part of a chunk's mesh at a level of detail 
+// that is the chunk's own: the height and normal of every vertex of the 
+// mesh made by makeGridMesh()
+//
+// The vertices are packed TerrainVertex values; with its grid point, the 
+// vertex shader scales a vertex by 1/TESS_FACTOR and 1/HEIGHT_PRECISION and 
+// moves it by half a square, so that each lands where the same corner of 
+// makeChunkSquare() did once that square was rotated into place. Normals 
+// come from gridNormals(); the chunk's apron stands in for its neighbours 
+// along the edges, so normals match across chunk borders.
+//
+// Each vertex also holds the height it morphs to on its way to the next 
+// coarser level. The shader moves a vertex in an odd row or column of this 
+// level back onto the even row or column before it, where the coarser mesh 
+// has its vertex; with the cells split along the same diagonal at every 
+// level, a fully morphed mesh is exactly the coarser mesh. The coarsest 
+// level never morphs.
+//
+// @param chunk - the chunk being meshed
+// @param lod - the level of detail, from 0 (every point) to 
+//        CHUNK_LOD_LEVELS - 1
+// @param points - the CHUNK_LOD_VERTICES(lod) grid points of the mesh, as 
+//        left by makeGridMesh() and optimizeGridMesh()
+// @param vertices - the CHUNK_LOD_VERTICES(lod) vertices of the mesh, one 
+//        for each grid point
+///
+void makeChunkMesh(const Chunk *chunk, int lod, 
+    const TerrainGridPoint *points, TerrainVertex *vertices)
+{
+    const int step = 1 << lod;
+    const int size = CHUNK_LOD_GRID_SIZE(lod);
+    const int coarsest = (lod == CHUNK_LOD_LEVELS - 1);
+    float padded[PADDED_POINTS];
+    float nx[GRID_POINTS], ny[GRID_POINTS], nz[GRID_POINTS];
+
+    paddedHeights(chunk, padded);
+    gridNormals(padded, nx, ny, nz);
+
+    // Heights are multiples of 1/HEIGHT_PRECISION, so packing them is exact
+    for(int v = 0; v < size * size; v++)
+    {
+        int gx = points[v].x;
+        int gy = points[v].z;
+        int p = GRID_INDEX(gx, gy);
+
+        // Where the vertex ends up once fully morphed
+        int mx = coarsest ? gx : gx - ((gx / step) & 1) * step;
+        int my = coarsest ? gy : gy - ((gy / step) & 1) * step;
+
+        float height = padded[PADDED_INDEX(gx, gy)];
+        float morph = padded[PADDED_INDEX(mx, my)];
+
+        vertices[v] = packTerrainVertex(
+            (int)lrintf(height * HEIGHT_PRECISION), 
+            (int)lrintf(morph * HEIGHT_PRECISION), nx[p], ny[p], nz[p]);
+    }
+}
+
+///
+// makeChunkHeightMap - lays out the heights of a chunk and its apron as the 
+// texels of a height map. The texel of point (gx, gy) is at column gx + 1 of 
+// row gy + 1, so the shader finds a point's height from its grid position 
+// alone; the corners, which are never read, repeat the chunk's corners.
+//
+// @param chunk - the chunk
+// @param texels - the CHUNK_HEIGHT_MAP_SIZE * CHUNK_HEIGHT_MAP_SIZE texels, 
+//        row by row
+///
+void makeChunkHeightMap(const Chunk *chunk, GLushort *texels)
+{
+    float padded[PADDED_POINTS];
+
+    paddedHeights(chunk, padded);
+
+    for(int gy = -1; gy <= CHUNK_GRID_SIZE; gy++)
+    {
+        for(int gx = -1; gx <= CHUNK_GRID_SIZE; gx++)
+        {
+            // Step the corners in onto the chunk
+            int px = gx;
+            int py = gy;
+            if((gx < 0 || gx == CHUNK_GRID_SIZE) && 
+                (gy < 0 || gy == CHUNK_GRID_SIZE))
+            {
+                px = gx < 0 ? 0 : CHUNK_GRID_SIZE - 1;
+                py = gy < 0 ? 0 : CHUNK_GRID_SIZE - 1;
+            }
+
+            // Heights are multiples of 1/HEIGHT_PRECISION, so this is exact
+            float height = padded[PADDED_INDEX(px, py)];
+            texels[(gy + 1) * CHUNK_HEIGHT_MAP_SIZE + (gx + 1)] = (GLushort)
+                (lrintf(height * HEIGHT_PRECISION) + HEIGHT_MAP_OFFSET);
+        }
+    }
+}
+
+///
+// rtinTriangle - finds the corners of a triangle of the error hierarchy
+//
+// The hierarchy is a right-triangulated irregular network: the grid is cut 
+// along its diagonal into two triangles, and every triangle is split at the 
+// middle of its hypotenuse into two halves, down to single cells. Numbering 
+// the two roots 2 and 3 and the children of triangle n 2n and 2n + 1, the 
+// bits of a triangle's number spell out the path to it from its root, so 
+// nothing has to be stored per triangle.
+//
+// @param t - the triangle, from 0 to RTIN_TRIANGLES - 1; coarser triangles 
+//        come first
+// @param a, b - set to the grid points at the ends of its hypotenuse
+///
+static void rtinTriangle(int t, int a[2], int b[2])
+{
+    int id = t + 2;
+    int c[2];
+
+    if(id & 1)
+    {
+        a[0] = 0; a[1] = 0;
+        b[0] = GRID_CELLS; b[1] = GRID_CELLS;
+        c[0] = GRID_CELLS; c[1] = 0;
+    }
+    else
+    {
+        a[0] = GRID_CELLS; a[1] = GRID_CELLS;
+        b[0] = 0; b[1] = 0;
+        c[0] = 0; c[1] = GRID_CELLS;
+    }
+
+    while((id >>= 1) > 1)
+    {
+        int mx = (a[0] + b[0]) >> 1;
+        int my = (a[1] + b[1]) >> 1;
+
+        if(id & 1)
+        {
+            b[0] = a[0]; b[1] = a[1];
+            a[0] = c[0]; a[1] = c[1];
+        }
+        else
+        {
+            a[0] = b[0]; a[1] = b[1];
+            b[0] = c[0]; b[1] = c[1];
+        }
+        c[0] = mx; c[1] = my;
+    }
+}
+
+///
+// computeChunkErrors - builds the error hierarchy of a chunk's heights
+//
+// The error at a point is how far the point's height is from the middle of 
+// the hypotenuse it splits, raised to the errors of the points that split 
+// its two halves; under a tolerance that is the same everywhere, a triangle 
+// whose point is within it can then be drawn whole without looking at 
+// anything below it. Triangles are visited finest first so every child is 
+// done before its parent. A point splits the hypotenuse of the triangles on 
+// both sides of it, and both raise it, so two neighbouring triangles always 
+// agree on whether to split and the mesh has no cracks.
+//
+// The adaptive mesh is drawn at level 0, so it has to morph into the level 1 
+// mesh like the full grid does. Every point the level 1 mesh keeps is given 
+// an infinite error, and so is the middle of every 2x2 block of cells that 
+// the hierarchy cuts along the other diagonal from the grid meshes. Every 
+// triangle of the adaptive mesh then lies within one triangle of the level 
+// 1 mesh, and sliding its odd vertices onto their even neighbours, as the 
+// morph does, turns it into exactly the level 1 mesh.
+//
+// Whether a point on the chunk's border is split at must also only depend 
+// on the border, which the neighbouring chunk has too, or the two meshes 
+// would not meet there. The border points the level 1 mesh does not keep 
+// sit in the finest triangles of the hierarchy, which have nothing below 
+// them, so their error is just how far they are from the middle of their 
+// two neighbours along the border. Both chunks then keep the same points of 
+// their shared border.
+//
+// @param chunk - the chunk; its errors are replaced
+///
+void computeChunkErrors(Chunk *chunk)
+{
+    float heights[GRID_POINTS];
+
+    for(int gx = 0; gx < CHUNK_GRID_SIZE; gx++)
+    {
+        for(int gy = 0; gy < CHUNK_GRID_SIZE; gy++)
+        {
+            int p = GRID_INDEX(gx, gy);
+            heights[p] = getPointHeight(chunk, gx, gy);
+            chunk->errors[p] = (gx % 2 == 0 && gy % 2 == 0) ? FLT_MAX : 0.0f;
+        }
+    }
+
+    for(int t = RTIN_TRIANGLES - 1; t >= 0; t--)
+    {
+        int a[2], b[2];
+        rtinTriangle(t, a, b);
+
+        int mx = (a[0] + b[0]) >> 1;
+        int my = (a[1] + b[1]) >> 1;
+        int middle = GRID_INDEX(mx, my);
+
+        float interpolated = 
+            (heights[GRID_INDEX(a[0], a[1])] + heights[GRID_INDEX(b[0], b[1])]) 
+            * 0.5f;
+        float error = fmaxf(chunk->errors[middle], 
+            fabsf(interpolated - heights[middle]));
+
+        if(t < RTIN_PARENTS)
+        {
+            // The right angle corner of the triangle, opposite the middle
+            int cx = mx + my - a[1];
+            int cy = my + a[0] - mx;
+
+            int left = GRID_INDEX((a[0] + cx) >> 1, (a[1] + cy) >> 1);
+            int right = GRID_INDEX((b[0] + cx) >> 1, (b[1] + cy) >> 1);
+
+            error = fmaxf(error, 
+                fmaxf(chunk->errors[left], chunk->errors[right]));
+        }
+
+        // The hypotenuse is the other diagonal of a 2x2 block of cells
+        if((a[0] - b[0]) * (a[1] - b[1]) == -4)
+        {
+            error = FLT_MAX;
+        }
+
+        chunk->errors[middle] = error;
+    }
+}
+
+///
+// adaptiveTriangle - adds a triangle of the hierarchy to a mesh, or its two 
+// halves if it is marked to be split at its point
+//
+// @param split - whether to split at each point, indexed like the grid
+// @param shape - the builder the indices are added to
+// @param ax, ay, bx, by - the ends of the triangle's hypotenuse
+// @param cx, cy - the triangle's right angle corner
+///
+static void adaptiveTriangle(const bool *split, ShapeBuilder *shape, 
+    int ax, int ay, int bx, int by, int cx, int cy)
+{
+    int mx = (ax + bx) >> 1;
+    int my = (ay + by) >> 1;
+
+    // Triangles of a single cell have no point to split at
+    if(abs(ax - cx) + abs(ay - cy) > 1 && split[GRID_INDEX(mx, my)])
+    {
+        adaptiveTriangle(split, shape, cx, cy, ax, ay, mx, my);
+        adaptiveTriangle(split, shape, bx, by, cx, cy, mx, my);
+        return;
+    }
+
+    int a = GRID_INDEX(ax, ay);
+    int b = GRID_INDEX(bx, by);
+    int c = GRID_INDEX(cx, cy);
+
+    // Wind every triangle the same way as the grid meshes
+    if((bx - ax) * (cy - ay) - (by - ay) * (cx - ax) > 0)
+    {
+        shapeAddIndexedTriangle(shape, a, c, b);
+    }
+    else
+    {
+        shapeAddIndexedTriangle(shape, a, b, c);
+    }
+}
+
+///
+// makeChunkAdaptiveMesh - creates the indices of a mesh for a whole chunk 
+// with as few triangles as its error hierarchy allows for a camera at a 
+// point: triangles are only split where leaving them whole would put some 
+// point of the chunk further off its height than errorSlope times its 
+// distance across the ground from the camera, or to keep the triangles of 
+// the level 1 mesh and the border points the neighbouring chunks keep (see 
+// computeChunkErrors()). A height error covers about the same part of the 
+// screen wherever its ratio to the distance is the same, so the mesh is 
+// fine close to the camera and coarse further away. Flat ground collapses 
+// to the level 1 mesh.
+//
+// A point's tolerance grows with its distance, so a point may be within 
+// its own while some point below it in the hierarchy, nearer the camera, is 
+// not. The points are visited finest first, and each is split at if its 
+// error is over its tolerance or either of its halves is split; that takes 
+// time linear in the size of the chunk. The split at a border point the 
+// level 1 mesh does not keep still only depends on the border and the 
+// camera, so chunks meshed for the same camera still meet.
+//
+// The indices are into the full detail grid, so the mesh is drawn with the 
+// grid points of makeGridMesh() and the vertices of makeChunkMesh() at 
+// level 0; points the mesh skips are simply never used. Their morph targets 
+// work unchanged, as the fully morphed mesh is the level 1 mesh.
+//
+// @param chunk - the chunk being meshed
+// @param eyeX, eyeY - where the camera is, in grid steps from the chunk's 
+//        first point
+// @param eyeRadius - how far the camera may be from there, in grid steps, 
+//        while the mesh is drawn
+// @param errorSlope - the height error allowed per grid step of distance
+// @param shape - the builder the indices are added to
+///
+void makeChunkAdaptiveMesh(const Chunk *chunk, float eyeX, float eyeY,
+    float eyeRadius, float errorSlope, ShapeBuilder *shape)
+{
+    bool split[GRID_POINTS];
+
+    for(int p = 0; p < GRID_POINTS; p++)
+    {
+        split[p] = false;
+    }
+
+    for(int t = RTIN_TRIANGLES - 1; t >= 0; t--)
+    {
+        int a[2], b[2];
+        rtinTriangle(t, a, b);
+
+        int mx = (a[0] + b[0]) >> 1;
+        int my = (a[1] + b[1]) >> 1;
+        int middle = GRID_INDEX(mx, my);
+
+        float distance = fmaxf(
+            hypotf((float)mx - eyeX, (float)my - eyeY) - eyeRadius, 0.0f);
+        bool splitHere = chunk->errors[middle] > errorSlope * distance;
+
+        if(t < RTIN_PARENTS)
+        {
+            // The right angle corner of the triangle, opposite the middle
+            int cx = mx + my - a[1];
+            int cy = my + a[0] - mx;
+
+            splitHere = splitHere || 
+                split[GRID_INDEX((a[0] + cx) >> 1, (a[1] + cy) >> 1)] ||
+                split[GRID_INDEX((b[0] + cx) >> 1, (b[1] + cy) >> 1)];
+        }
+
+        // A point splits the triangles on both sides of it
+        split[middle] = split[middle] || splitHere;
+    }
+
+    adaptiveTriangle(split, shape, 
+        0, 0, GRID_CELLS, GRID_CELLS, GRID_CELLS, 0);
+    adaptiveTriangle(split, shape, 
+        GRID_CELLS, GRID_CELLS, 0, 0, 0, GRID_CELLS);
+}
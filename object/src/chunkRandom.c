@@ -0,0 +1,72 @@
+///
+// chunkRandom.c
+//
+// Counter-based random numbers for terrain generation.
+//
+// This code can be compiled as either C or C++.
+//
+// @author T. Wilgenbusch
+///
+
+#include "chunkRandom.h"
+
+// The golden ratio increment used by SplitMix64
+#define GOLDEN_GAMMA 0x9E3779B97F4A7C15ull
+
+///
+// randomMix - the SplitMix64 mixing function
+//
+// @param x - the value being mixed
+//
+// @return A well distributed 64-bit hash of x
+///
+uint64_t randomMix(uint64_t x)
+{
+    x += GOLDEN_GAMMA;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+///
+// randomKey - derives the key for an integer coordinate in a world
+//
+// @param worldSeed - the seed of the world
+// @param x, y - the coordinate
+//
+// @return The key for (x, y)
+///
+uint64_t randomKey(uint64_t worldSeed, int x, int y)
+{
+    uint64_t coord = ((uint64_t)(uint32_t)x << 32) | (uint64_t)(uint32_t)y;
+    return randomMix(worldSeed ^ randomMix(coord));
+}
+
+///
+// randomAt - the random value number counter of a key
+//
+// @param key - a key from randomKey()
+// @param counter - which value of the key to return
+//
+// @return A uniformly distributed 64-bit value
+///
+uint64_t randomAt(uint64_t key, uint64_t counter)
+{
+    return randomMix(key + counter * GOLDEN_GAMMA);
+}
+
+///
+// randomRangeAt - randomAt() mapped onto a range of floats
+//
+// @param key - a key from randomKey()
+// @param counter - which value of the key to return
+// @param min, max - the bounds of the range
+//
+// @return A value between min and max
+///
+float randomRangeAt(uint64_t key, uint64_t counter, float min, float max)
+{
+    // The top 24 bits fill a float's mantissa exactly
+    float unit = (float)(randomAt(key, counter) >> 40) / (float)(1 << 24);
+    return min + (max - min) * unit;
+}
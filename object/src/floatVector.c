@@ -7,8 +7,12 @@
 // Date:    2013/10/16 10:43:50
 ///
 
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "floatVector.h"
@@ -16,11 +20,60 @@
 ///
 // Default amount to "grow" the vector by when it fills up
 //
-// Smaller values => more frequent growth, but higher utilization
-// Larger values =>  less frequent growth, but potentially more wasted space
+// This is the smallest amount the vector grows by; past that it doubles
+// in length, so pushing n floats costs O(n) overall
 ///
 #define DEFAULT_GROWTH  256
 
+///
+// floatVectorGrow -- move a vector to new aligned storage of at least
+// `needed` slots
+//
+// If the memory allocation fails, prints an error message and exits.
+///
+static void floatVectorGrow( floatVector_t *vec, size_t needed )
+{
+    void *tmp;
+
+    if( vec->growth == 0 ) 
+    {
+        vec->growth = DEFAULT_GROWTH;
+    }
+
+    // grow geometrically, by at least the growth factor
+    size_t length = vec->length * 2;
+    if( length < vec->length + vec->growth )
+    {
+        length = vec->length + vec->growth;
+    }
+    if( length < needed )
+    {
+        length = needed;
+    }
+
+    if( posix_memalign( &tmp, FLOAT_VECTOR_ALIGNMENT,
+            length * sizeof(float) ) != 0 )
+    {
+        perror( "vector reallocation failed" );
+        exit( 2 );
+    }
+
+    // move over the contents and release the old storage, unless it was
+    // the caller's buffer
+    if( vec->size > 0 )
+    {
+        memcpy( tmp, vec->vec, vec->size * sizeof(float) );
+    }
+    if( vec->vec != 0 && !vec->external )
+    {
+        free( vec->vec );
+    }
+
+    vec->vec = (float *) tmp;
+    vec->length = length;
+    vec->external = 0;
+}
+
 ///
 // floatVectorGrowthFactor -- set the growth factor for a floatVector_t
 //
@@ -47,12 +100,16 @@ void floatVectorClear( floatVector_t *vec )
     // release any existing allocated space
     if( vec->vec != 0 ) 
     {
-        free( vec->vec );
+        if( !vec->external ) 
+        {
+            free( vec->vec );
+        }
         vec->vec = 0;
     }
 
     // record the fact that the vector is now empty
     vec->length = vec->size = 0;
+    vec->external = 0;
 
     // ensure that there is a growth factor for this vector
     if( vec->growth == 0 ) 
@@ -62,56 +119,113 @@ void floatVectorClear( floatVector_t *vec )
 }
 
 ///
-// floatVectorPushBack -- add a float to the end of the vector,
-// automatically extending the vector if need be
+// floatVectorReserve -- make room for at least `length` floats
 ///
-void floatVectorPushBack( floatVector_t *vec, float coord ) 
+void floatVectorReserve( floatVector_t *vec, size_t length )
 {
-    float *tmp;
-
     // verify that we were given a non-NULL pointer
     if( vec == 0 ) 
     {
         return;
     }
 
-    // allocate initial vector if we need to
-    if( vec->length == 0 ) 
+    if( length > vec->length )
     {
-        if( vec->growth == 0 ) 
-        {
-            vec->growth = DEFAULT_GROWTH;
-        }
+        floatVectorGrow( vec, length );
+    }
+}
 
-        tmp = (float *) malloc( vec->growth * sizeof(float) );
-        if( tmp == 0 ) 
-        {
-            perror( "vector allocation failed" );
-            exit( 1 );
-        }
-        vec->vec = tmp;
-        vec->length = vec->growth;
+///
+// floatVectorPushBack -- add a float to the end of the vector,
+// automatically extending the vector if need be
+///
+void floatVectorPushBack( floatVector_t *vec, float coord ) 
+{
+    // verify that we were given a non-NULL pointer
+    if( vec == 0 ) 
+    {
+        return;
     }
 
     // extend the vector if we need to
     if( vec->size >= vec->length ) 
     {
-        if( vec->growth == 0 ) 
-        {
-            vec->growth = DEFAULT_GROWTH;
-        }
-        tmp = (float *) realloc( vec->vec,
-                     (vec->length + vec->growth) * sizeof(float) );
-        if( tmp == 0 ) 
-        {
-            perror( "vector reallocation failed" );
-            exit( 2 );
-        }
-        vec->vec = tmp;
-        vec->length += vec->growth;
+        floatVectorGrow( vec, vec->size + 1 );
     }
 
     // add the new coordinate to the vector
     vec->vec[ vec->size ] = coord;
     vec->size += 1;
 }
+
+///
+// floatVectorPushBackN -- add n floats to the end of the vector,
+// automatically extending the vector if need be
+///
+void floatVectorPushBackN( floatVector_t *vec, const float *values, size_t n )
+{
+    // verify that we were given a non-NULL pointer
+    if( vec == 0 || n == 0 )
+    {
+        return;
+    }
+
+    // extend the vector if we need to; values may point into the vector
+    // itself (appending a vector to itself), in which case they move along
+    // with the storage
+    if( vec->size + n > vec->length )
+    {
+        uintptr_t start = (uintptr_t) vec->vec;
+        uintptr_t source = (uintptr_t) values;
+        int inside = vec->vec != 0 && source >= start &&
+            source < start + vec->length * sizeof(float);
+        size_t offset = (source - start) / sizeof(float);
+
+        floatVectorGrow( vec, vec->size + n );
+
+        if( inside )
+        {
+            values = vec->vec + offset;
+        }
+    }
+
+    // add the new values to the vector
+    memmove( vec->vec + vec->size, values, n * sizeof(float) );
+    vec->size += n;
+}
+
+///
+// floatVectorAppend -- add the contents of one vector to the end of another
+///
+void floatVectorAppend( floatVector_t *vec, const floatVector_t *other )
+{
+    // verify that we were given a non-NULL pointer
+    if( other == 0 )
+    {
+        return;
+    }
+
+    floatVectorPushBackN( vec, other->vec, other->size );
+}
+
+///
+// floatVectorUseBuffer -- empty a floatVector_t and have it fill the
+// caller's buffer
+///
+void floatVectorUseBuffer( floatVector_t *vec, float *buffer, size_t length ) 
+{
+    // verify that we were given a non-NULL pointer
+    if( vec == 0 ) 
+    {
+        return;
+    }
+
+    floatVectorClear( vec );
+
+    if( buffer != 0 && length > 0 ) 
+    {
+        vec->vec = buffer;
+        vec->length = length;
+        vec->external = 1;
+    }
+}
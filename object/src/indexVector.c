@@ -0,0 +1,119 @@
+///
+// indexVector.c
+//
+// A growable array of vertex indices, modeled after floatVector_t; used for 
+// the element data of indexed meshes.
+//
+// @author T. Wilgenbusch
+///
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "indexVector.h"
+
+///
+// Default amount to "grow" the vector by when it fills up; past that it 
+// doubles in length, as a floatVector does
+///
+#define DEFAULT_GROWTH  256
+
+///
+// indexVectorGrow -- extend a vector to at least `needed` slots
+///
+static void indexVectorGrow( indexVector_t *vec, size_t needed )
+{
+    unsigned int *tmp;
+
+    if( vec->growth == 0 ) 
+    {
+        vec->growth = DEFAULT_GROWTH;
+    }
+
+    size_t length = vec->length * 2;
+    if( length < vec->length + vec->growth ) 
+    {
+        length = vec->length + vec->growth;
+    }
+    if( length < needed ) 
+    {
+        length = needed;
+    }
+
+    tmp = (unsigned int *) realloc( vec->vec, length * sizeof(unsigned int) );
+    if( tmp == 0 ) 
+    {
+        perror( "vector reallocation failed" );
+        exit( 2 );
+    }
+    vec->vec = tmp;
+    vec->length = length;
+}
+
+///
+// indexVectorClear -- return an indexVector_t to its original state
+///
+void indexVectorClear( indexVector_t *vec ) 
+{
+    // verify that we were given a non-NULL pointer
+    if( vec == 0 ) 
+    {
+        return;
+    }
+
+    // release any existing allocated space
+    if( vec->vec != 0 ) 
+    {
+        free( vec->vec );
+        vec->vec = 0;
+    }
+
+    // record the fact that the vector is now empty
+    vec->length = vec->size = 0;
+
+    // ensure that there is a growth factor for this vector
+    if( vec->growth == 0 ) 
+    {
+        vec->growth = DEFAULT_GROWTH;
+    }
+}
+
+///
+// indexVectorReserve -- make room for at least `length` indices
+///
+void indexVectorReserve( indexVector_t *vec, size_t length ) 
+{
+    // verify that we were given a non-NULL pointer
+    if( vec == 0 ) 
+    {
+        return;
+    }
+
+    if( length > vec->length ) 
+    {
+        indexVectorGrow( vec, length );
+    }
+}
+
+///
+// indexVectorPushBack -- add an index to the end of the vector,
+// automatically extending the vector if need be
+///
+void indexVectorPushBack( indexVector_t *vec, unsigned int index ) 
+{
+    // verify that we were given a non-NULL pointer
+    if( vec == 0 ) 
+    {
+        return;
+    }
+
+    // extend the vector if we need to
+    if( vec->size >= vec->length ) 
+    {
+        indexVectorGrow( vec, vec->size + 1 );
+    }
+
+    // add the new index to the vector
+    vec->vec[ vec->size ] = index;
+    vec->size += 1;
+}
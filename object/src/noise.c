@@ -0,0 +1,383 @@
+///
+// noise.c
+//
+// Gradient (Perlin) noise and fractal Brownian motion for generating terrain
+// heights.
+//
+// Gradients are picked by hashing the integer lattice coordinates with the
+// seed rather than through a permutation table, so the vector paths never
+// need a gather. The vector and scalar paths perform the same operations in
+// the same order, so they produce identical values.
+//
+// This code can be compiled as either C or C++.
+//
+// @author T. Wilgenbusch
+///
+
+#include "noise.h"
+
+#ifdef __cplusplus
+#include <cmath>
+#else
+#include <math.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Multipliers used to hash the lattice coordinates
+#define HASH_X 0x27d4eb2du
+#define HASH_Y 0x165667b1u
+#define HASH_MIX 0x85ebca6bu
+
+///
+// hashCorner - hashes a lattice corner with the seed
+//
+// @param ix, iy - the integer lattice coordinates
+// @param seed - the noise seed
+//
+// @return The hash of the corner
+///
+static unsigned int hashCorner(int ix, int iy, unsigned int seed)
+{
+    unsigned int h = seed ^ ((unsigned int)ix * HASH_X) ^ ((unsigned int)iy * HASH_Y);
+    h ^= h >> 15;
+    h *= HASH_MIX;
+    h ^= h >> 13;
+    return h;
+}
+
+///
+// gradient - dots the offset from a lattice corner with the corner's gradient;
+// the gradient is one of the four diagonals, chosen by the corner's hash
+//
+// @param h - the hash of the corner
+// @param x, y - the offset of the sample from the corner
+//
+// @return The dot product of the gradient with the offset
+///
+static float gradient(unsigned int h, float x, float y)
+{
+    return ((h & 1) ? -x : x) + ((h & 2) ? -y : y);
+}
+
+///
+// fade - Perlin's quintic smoothing curve, 6t^5 - 15t^4 + 10t^3
+///
+static float fade(float t)
+{
+    return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+///
+// noise2 - scalar reference 2-d gradient noise
+//
+// @param x, y - the position being sampled
+// @param seed - selects the gradients used
+//
+// @return The noise value at (x, y), roughly between -1 and 1
+///
+float noise2(float x, float y, unsigned int seed)
+{
+    float fx = floorf(x);
+    float fy = floorf(y);
+    int ix = (int)fx;
+    int iy = (int)fy;
+    float dx = x - fx;
+    float dy = y - fy;
+
+    float n00 = gradient(hashCorner(ix, iy, seed), dx, dy);
+    float n10 = gradient(hashCorner(ix + 1, iy, seed), dx - 1.0f, dy);
+    float n01 = gradient(hashCorner(ix, iy + 1, seed), dx, dy - 1.0f);
+    float n11 = gradient(hashCorner(ix + 1, iy + 1, seed), dx - 1.0f, dy - 1.0f);
+
+    float u = fade(dx);
+    float v = fade(dy);
+
+    float a = n00 + (n10 - n00) * u;
+    float b = n01 + (n11 - n01) * u;
+    return a + (b - a) * v;
+}
+
+#if defined(__AVX2__)
+
+///
+// AVX2 versions of the helpers above, each working on 8 lanes
+///
+static __m256i hashCorner8(__m256i ix, __m256i iy, __m256i seed)
+{
+    __m256i h = _mm256_xor_si256(seed,
+        _mm256_xor_si256(_mm256_mullo_epi32(ix, _mm256_set1_epi32((int)HASH_X)),
+                         _mm256_mullo_epi32(iy, _mm256_set1_epi32((int)HASH_Y))));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32((int)HASH_MIX));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 13));
+    return h;
+}
+
+static __m256 gradient8(__m256i h, __m256 x, __m256 y)
+{
+    // Move hash bits 0 and 1 into the sign bits of x and y
+    __m256 sx = _mm256_castsi256_ps(_mm256_slli_epi32(h, 31));
+    __m256 sy = _mm256_castsi256_ps(
+        _mm256_slli_epi32(_mm256_srli_epi32(h, 1), 31));
+    return _mm256_add_ps(_mm256_xor_ps(x, sx), _mm256_xor_ps(y, sy));
+}
+
+static __m256 fade8(__m256 t)
+{
+    __m256 t3 = _mm256_mul_ps(_mm256_mul_ps(t, t), t);
+    __m256 inner = _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6.0f)),
+        _mm256_set1_ps(15.0f));
+    inner = _mm256_add_ps(_mm256_mul_ps(t, inner), _mm256_set1_ps(10.0f));
+    return _mm256_mul_ps(t3, inner);
+}
+
+static __m256 noise8(__m256 x, __m256 y, __m256i seed)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256i ione = _mm256_set1_epi32(1);
+
+    __m256 fx = _mm256_floor_ps(x);
+    __m256 fy = _mm256_floor_ps(y);
+    __m256i ix = _mm256_cvttps_epi32(fx);
+    __m256i iy = _mm256_cvttps_epi32(fy);
+    __m256i ix1 = _mm256_add_epi32(ix, ione);
+    __m256i iy1 = _mm256_add_epi32(iy, ione);
+    __m256 dx = _mm256_sub_ps(x, fx);
+    __m256 dy = _mm256_sub_ps(y, fy);
+    __m256 dx1 = _mm256_sub_ps(dx, one);
+    __m256 dy1 = _mm256_sub_ps(dy, one);
+
+    __m256 n00 = gradient8(hashCorner8(ix, iy, seed), dx, dy);
+    __m256 n10 = gradient8(hashCorner8(ix1, iy, seed), dx1, dy);
+    __m256 n01 = gradient8(hashCorner8(ix, iy1, seed), dx, dy1);
+    __m256 n11 = gradient8(hashCorner8(ix1, iy1, seed), dx1, dy1);
+
+    __m256 u = fade8(dx);
+    __m256 v = fade8(dy);
+
+    __m256 a = _mm256_add_ps(n00, _mm256_mul_ps(_mm256_sub_ps(n10, n00), u));
+    __m256 b = _mm256_add_ps(n01, _mm256_mul_ps(_mm256_sub_ps(n11, n01), u));
+    return _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), v));
+}
+
+#elif defined(__SSE2__)
+
+///
+// SSE2 versions of the helpers above, each working on 4 lanes
+///
+
+// SSE2 has no 32-bit low multiply, so build one from two 64-bit multiplies
+static __m128i mullo4(__m128i a, __m128i b)
+{
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// SSE2 has no floor either; truncate and step down where that rounded up
+static __m128 floor4(__m128 x)
+{
+    __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x), _mm_set1_ps(1.0f)));
+}
+
+static __m128i hashCorner4(__m128i ix, __m128i iy, __m128i seed)
+{
+    __m128i h = _mm_xor_si128(seed,
+        _mm_xor_si128(mullo4(ix, _mm_set1_epi32((int)HASH_X)),
+                      mullo4(iy, _mm_set1_epi32((int)HASH_Y))));
+    h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+    h = mullo4(h, _mm_set1_epi32((int)HASH_MIX));
+    h = _mm_xor_si128(h, _mm_srli_epi32(h, 13));
+    return h;
+}
+
+static __m128 gradient4(__m128i h, __m128 x, __m128 y)
+{
+    __m128 sx = _mm_castsi128_ps(_mm_slli_epi32(h, 31));
+    __m128 sy = _mm_castsi128_ps(_mm_slli_epi32(_mm_srli_epi32(h, 1), 31));
+    return _mm_add_ps(_mm_xor_ps(x, sx), _mm_xor_ps(y, sy));
+}
+
+static __m128 fade4(__m128 t)
+{
+    __m128 t3 = _mm_mul_ps(_mm_mul_ps(t, t), t);
+    __m128 inner = _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.0f)),
+        _mm_set1_ps(15.0f));
+    inner = _mm_add_ps(_mm_mul_ps(t, inner), _mm_set1_ps(10.0f));
+    return _mm_mul_ps(t3, inner);
+}
+
+static __m128 noise4(__m128 x, __m128 y, __m128i seed)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128i ione = _mm_set1_epi32(1);
+
+    __m128 fx = floor4(x);
+    __m128 fy = floor4(y);
+    __m128i ix = _mm_cvttps_epi32(fx);
+    __m128i iy = _mm_cvttps_epi32(fy);
+    __m128i ix1 = _mm_add_epi32(ix, ione);
+    __m128i iy1 = _mm_add_epi32(iy, ione);
+    __m128 dx = _mm_sub_ps(x, fx);
+    __m128 dy = _mm_sub_ps(y, fy);
+    __m128 dx1 = _mm_sub_ps(dx, one);
+    __m128 dy1 = _mm_sub_ps(dy, one);
+
+    __m128 n00 = gradient4(hashCorner4(ix, iy, seed), dx, dy);
+    __m128 n10 = gradient4(hashCorner4(ix1, iy, seed), dx1, dy);
+    __m128 n01 = gradient4(hashCorner4(ix, iy1, seed), dx, dy1);
+    __m128 n11 = gradient4(hashCorner4(ix1, iy1, seed), dx1, dy1);
+
+    __m128 u = fade4(dx);
+    __m128 v = fade4(dy);
+
+    __m128 a = _mm_add_ps(n00, _mm_mul_ps(_mm_sub_ps(n10, n00), u));
+    __m128 b = _mm_add_ps(n01, _mm_mul_ps(_mm_sub_ps(n11, n01), u));
+    return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), v));
+}
+
+#endif
+
+///
+// noise2Batch - evaluates noise2() at n positions
+//
+// @param x, y - the positions being sampled
+// @param out - the array the n noise values are written to
+// @param n - the number of positions
+// @param seed - selects the gradients used
+///
+void noise2Batch(const float *x, const float *y, float *out, int n,
+    unsigned int seed)
+{
+    int i = 0;
+
+#if defined(__AVX2__)
+    __m256i vseed = _mm256_set1_epi32((int)seed);
+    for(; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_ps(out + i,
+            noise8(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), vseed));
+    }
+#elif defined(__SSE2__)
+    __m128i vseed = _mm_set1_epi32((int)seed);
+    for(; i + 4 <= n; i += 4)
+    {
+        _mm_storeu_ps(out + i,
+            noise4(_mm_loadu_ps(x + i), _mm_loadu_ps(y + i), vseed));
+    }
+#endif
+
+    for(; i < n; i++)
+    {
+        out[i] = noise2(x[i], y[i], seed);
+    }
+}
+
+///
+// noise2Accumulate - adds a scaled octave of noise to n values;
+// out[i] += amplitude * noise2(x[i] * frequency, y[i] * frequency, seed)
+//
+// @param x, y - the positions being sampled
+// @param out - the values the octave is added to
+// @param n - the number of positions
+// @param seed - selects the gradients used
+// @param frequency - scale applied to the positions
+// @param amplitude - scale applied to the noise
+///
+void noise2Accumulate(const float *x, const float *y, float *out, int n,
+    unsigned int seed, float frequency, float amplitude)
+{
+    int i = 0;
+
+#if defined(__AVX2__)
+    __m256i vseed = _mm256_set1_epi32((int)seed);
+    __m256 vfreq = _mm256_set1_ps(frequency);
+    __m256 vamp = _mm256_set1_ps(amplitude);
+    for(; i + 8 <= n; i += 8)
+    {
+        __m256 value = noise8(_mm256_mul_ps(_mm256_loadu_ps(x + i), vfreq),
+            _mm256_mul_ps(_mm256_loadu_ps(y + i), vfreq), vseed);
+        _mm256_storeu_ps(out + i,
+            _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_mul_ps(vamp, value)));
+    }
+#elif defined(__SSE2__)
+    __m128i vseed = _mm_set1_epi32((int)seed);
+    __m128 vfreq = _mm_set1_ps(frequency);
+    __m128 vamp = _mm_set1_ps(amplitude);
+    for(; i + 4 <= n; i += 4)
+    {
+        __m128 value = noise4(_mm_mul_ps(_mm_loadu_ps(x + i), vfreq),
+            _mm_mul_ps(_mm_loadu_ps(y + i), vfreq), vseed);
+        _mm_storeu_ps(out + i,
+            _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(vamp, value)));
+    }
+#endif
+
+    for(; i < n; i++)
+    {
+        out[i] += amplitude * noise2(x[i] * frequency, y[i] * frequency, seed);
+    }
+}
+
+///
+// fbm2 - scalar reference fractal Brownian motion; the sum of a number of
+// octaves of noise2(), normalized to the range of a single octave
+//
+// @param x, y - the position being sampled
+// @param seed - selects the gradients used
+// @param octaves - the number of octaves summed
+// @param lacunarity - how much the frequency grows each octave
+// @param gain - how much the amplitude shrinks each octave
+//
+// @return The fBm value at (x, y)
+///
+float fbm2(float x, float y, unsigned int seed, int octaves,
+    float lacunarity, float gain)
+{
+    float total = 0.0f;
+    float frequency = 1.0f;
+    float amplitude = 1.0f;
+    float result = 0.0f;
+
+    for(int o = 0; o < octaves; o++)
+    {
+        total += amplitude;
+        amplitude *= gain;
+    }
+
+    amplitude = 1.0f;
+    for(int o = 0; o < octaves; o++)
+    {
+        result += (amplitude / total) * noise2(x * frequency, y * frequency,
+            seed + (unsigned int)o * NOISE_OCTAVE_SEED);
+        frequency *= lacunarity;
+        amplitude *= gain;
+    }
+
+    return result;
+}
+
+// The default fBm, specialized on the NOISE_* settings
+NOISE_DEFINE_FBM(defaultFbm, NOISE_OCTAVES, NOISE_LACUNARITY, NOISE_GAIN)
+
+///
+// fbm2Batch - evaluates fbm2() at n positions using NOISE_OCTAVES,
+// NOISE_LACUNARITY and NOISE_GAIN
+//
+// @param x, y - the positions being sampled
+// @param out - the array the n values are written to
+// @param n - the number of positions
+// @param seed - selects the gradients used
+///
+void fbm2Batch(const float *x, const float *y, float *out, int n,
+    unsigned int seed)
+{
+    defaultFbm(x, y, out, n, seed);
+}
@@ -3,6 +3,10 @@
 //
 // Routines for adding triangles to create a new mesh
 //
+// Every routine works on an explicit ShapeBuilder, so any number of meshes
+// (on any number of threads) can be built at once. The original functions
+// without a builder argument work on a single default builder.
+//
 // @author T. Wilgenbusch
 ///
 
@@ -17,113 +21,167 @@
 #include <stdlib.h>
 
 #include "simpleShape.h"
-#include "floatVector.h"
+#include "vertexCache.h"
 
 ///
-// common variables...should probably make this a class and make these
-// data members
+// The builder used by the functions that do not take one
 ///
-floatVector_t points;
-floatVector_t normals;
-floatVector_t uv;
-float *pointArray = 0;
-float *normalArray = 0;
-float *uvArray = 0;
-GLushort *elemArray = 0;
+static ShapeBuilder defaultShape;
 
 ///
-// clear the current shape
+// makeShapeBuilder - allocates an empty ShapeBuilder
+//
+// @return A pointer to the new builder
 ///
-void clearShape ()
+ShapeBuilder *makeShapeBuilder()
 {
-    if (pointArray) {
-        free( pointArray );
-        free( elemArray );
-        free( normalArray );
-        free( uvArray );
-        pointArray = 0;
-        elemArray = 0;
-        normalArray = 0;
-        uvArray = 0;
+    ShapeBuilder *shape = (ShapeBuilder *)calloc(1, sizeof(ShapeBuilder));
+    if( shape == 0 ) {
+        perror( "shape builder allocation failed" );
+	exit( 1 );
     }
-    floatVectorClear( &points );
-    floatVectorClear( &normals );
-    floatVectorClear( &uv );
+    return shape;
 }
 
 ///
-// adds a triangle to the current shape
+// destroyShapeBuilder - deallocates a ShapeBuilder and everything in it
+//
+// @param shape - the builder to destroy
+///
+void destroyShapeBuilder(ShapeBuilder *shape)
+{
+    if(shape)
+    {
+        shapeClear(shape);
+        free(shape);
+    }
+}
+
+///
+// clear the shape in a builder
+///
+void shapeClear (ShapeBuilder *shape)
+{
+    if (shape->elemArray) {
+        free( shape->elemArray );
+        shape->elemArray = 0;
+    }
+    if (shape->indexArray) {
+        free( shape->indexArray );
+        shape->indexArray = 0;
+    }
+    if (shape->elementArray) {
+        free( shape->elementArray );
+        shape->elementArray = 0;
+    }
+    shape->maxIndex = 0;
+    floatVectorClear( &shape->points );
+    floatVectorClear( &shape->normals );
+    floatVectorClear( &shape->uv );
+    indexVectorClear( &shape->indices );
+}
+
+///
+// clear a builder and build the next shape straight into a caller's buffer;
+// if more than `vertices` vertices are added, the shape moves back into the
+// builder's own storage
+///
+void shapeBuildInto (ShapeBuilder *shape, float *dest, int vertices)
+{
+    shapeClear( shape );
+    floatVectorUseBuffer( &shape->points, dest, vertices * 4 );
+    floatVectorUseBuffer( &shape->normals, dest + vertices * 4, vertices * 3 );
+    floatVectorUseBuffer( &shape->uv, dest + vertices * 7, vertices * 2 );
+}
+
+///
+// make room in a builder for a number of vertices and indices, so that
+// adding up to that many never reallocates
+///
+void shapeReserve (ShapeBuilder *shape, int vertices, int indices)
+{
+    floatVectorReserve( &shape->points, vertices * 4 );
+    floatVectorReserve( &shape->normals, vertices * 3 );
+    floatVectorReserve( &shape->uv, vertices * 2 );
+    indexVectorReserve( &shape->indices, indices );
+}
+
 ///
-void addTriangleWithTexCoords(float x0, float y0, float z0, float u0, float v0, 
-                  float x1, float y1, float z1, float u1, float v1, 
+// adds a single vertex to a shape, to be shared by any number of
+// triangles added with shapeAddIndexedTriangle()
+//
+// @return The index of the new vertex
+///
+int shapeAddVertex(ShapeBuilder *shape, float x, float y, float z,
+    float nx, float ny, float nz, float u, float v)
+{
+    float point[4] = { x, y, z, 1.0f };
+    float normal[3] = { nx, ny, nz };
+    float texCoord[2] = { u, v };
+
+    floatVectorPushBackN( &shape->points, point, 4 );
+    floatVectorPushBackN( &shape->normals, normal, 3 );
+    floatVectorPushBackN( &shape->uv, texCoord, 2 );
+
+    return shapeVertices(shape) - 1;
+}
+
+///
+// adds a triangle made of three vertices already added with shapeAddVertex()
+///
+void shapeAddIndexedTriangle(ShapeBuilder *shape, int i0, int i1, int i2)
+{
+    indexVectorPushBack( &shape->indices, i0 );
+    indexVectorPushBack( &shape->indices, i1 );
+    indexVectorPushBack( &shape->indices, i2 );
+
+    // track the largest index, which decides the width of the elements
+    if( (unsigned int) i0 > shape->maxIndex ) shape->maxIndex = i0;
+    if( (unsigned int) i1 > shape->maxIndex ) shape->maxIndex = i1;
+    if( (unsigned int) i2 > shape->maxIndex ) shape->maxIndex = i2;
+}
+
+///
+// adds a triangle to a shape
+///
+void shapeAddTriangleWithTexCoords(ShapeBuilder *shape,
+                  float x0, float y0, float z0, float u0, float v0,
+                  float x1, float y1, float z1, float u1, float v1,
                   float x2, float y2, float z2, float u2, float v2)
 {
+    float triangle[12] = {
+        x0, y0, z0, 1.0f,
+        x1, y1, z1, 1.0f,
+        x2, y2, z2, 1.0f
+    };
+    float texCoords[6] = { u0, v0, u1, v1, u2, v2 };
+
+    floatVectorPushBackN( &shape->points, triangle, 12 );
 
-    floatVectorPushBack( &points, x0 );
-    floatVectorPushBack( &points, y0 );
-    floatVectorPushBack( &points, z0 );
-    floatVectorPushBack( &points, 1.0 );
-    
-    floatVectorPushBack( &points, x1 );
-    floatVectorPushBack( &points, y1 );
-    floatVectorPushBack( &points, z1 );
-    floatVectorPushBack( &points, 1.0 );
-    
-    floatVectorPushBack( &points, x2 );
-    floatVectorPushBack( &points, y2 );
-    floatVectorPushBack( &points, z2 );
-    floatVectorPushBack( &points, 1.0 );
-    
     // calculate the normal
     float ux = x1 - x0;
     float uy = y1 - y0;
     float uz = z1 - z0;
-    
+
     float vx = x2 - x0;
     float vy = y2 - y0;
     float vz = z2 - z0;
-    
+
     float nx = (uy * vz) - (uz * vy);
     float ny = (uz * vx) - (ux * vz);
     float nz = (ux * vy) - (uy * vx);
 
-    for(int i = 0; i < 3; i++)
-    {
-        floatVectorPushBack( &normals, nx );
-        floatVectorPushBack( &normals, ny );
-        floatVectorPushBack( &normals, nz );        
-    }    
-
-    // Attach the normal to all 3 vertices
-    // NOTE: This was updated to give the normals for a SPHERE;
-    // will most likely not work for any other primitive shape
-    // floatVectorPushBack( &normals, x0 );
-    // floatVectorPushBack( &normals, y0 );
-    // floatVectorPushBack( &normals, z0);
-
-    // floatVectorPushBack( &normals, x1 );
-    // floatVectorPushBack( &normals, y1 );
-    // floatVectorPushBack( &normals, z1 );
-
-    // floatVectorPushBack( &normals, x2 );
-    // floatVectorPushBack( &normals, y2 );
-    // floatVectorPushBack( &normals, z2 );
+    float normals[9] = { nx, ny, nz, nx, ny, nz, nx, ny, nz };
+    floatVectorPushBackN( &shape->normals, normals, 9 );
 
-    
     // Attach the texture coords
-    floatVectorPushBack( &uv, u0 );
-    floatVectorPushBack( &uv, v0 );
-    floatVectorPushBack( &uv, u1 );
-    floatVectorPushBack( &uv, v1 );
-    floatVectorPushBack( &uv, u2 );
-    floatVectorPushBack( &uv, v2 );
-    
+    floatVectorPushBackN( &shape->uv, texCoords, 6 );
 }
 
 ///
-// adds a triangle to the current shape using calculated normals
+// adds a triangle to a shape using calculated normals
 ///
-void addTriangle(
+void shapeAddTriangle(ShapeBuilder *shape,
     float x0, float y0, float z0,
     float x1, float y1, float z1,
     float x2, float y2, float z2 )
@@ -142,16 +200,16 @@ void addTriangle(
     float nz = (ux * vy) - (uy * vx);
 
     // Attach the normal to all 3 vertices
-    addTriangleWithNorms(
+    shapeAddTriangleWithNorms( shape,
         x0, y0, z0, x1, y1, z1, x2, y2, z2,
         nx, ny, nz, nx, ny, nz, nx, ny, nz
     );
 }
 
 ///
-// adds a triangle to the current shape using supplied normals
+// adds a triangle to a shape using supplied normals
 ///
-void addTriangleWithNorms(
+void shapeAddTriangleWithNorms(ShapeBuilder *shape,
     float x0, float y0, float z0,
     float x1, float y1, float z1,
     float x2, float y2, float z2,
@@ -159,161 +217,407 @@ void addTriangleWithNorms(
     float nx1, float ny1, float nz1,
     float nx2, float ny2, float nz2 )
 {
-    floatVectorPushBack( &points, x0 );
-    floatVectorPushBack( &points, y0 );
-    floatVectorPushBack( &points, z0 );
-    floatVectorPushBack( &points, 1.0 );
+    float triangle[12] = {
+        x0, y0, z0, 1.0f,
+        x1, y1, z1, 1.0f,
+        x2, y2, z2, 1.0f
+    };
+    float normals[9] = {
+        nx0, ny0, nz0,
+        nx1, ny1, nz1,
+        nx2, ny2, nz2
+    };
+
+    floatVectorPushBackN( &shape->points, triangle, 12 );
+    floatVectorPushBackN( &shape->normals, normals, 9 );
+}
 
-    floatVectorPushBack( &normals, nx0 );
-    floatVectorPushBack( &normals, ny0 );
-    floatVectorPushBack( &normals, nz0 );
+///
+// adds only a triangle's vertices to a shape
+///
+void shapeAddTriangleVertices(ShapeBuilder *shape,
+    float x0, float y0, float z0,
+    float x1, float y1, float z1,
+    float x2, float y2, float z2 )
+{
+    float triangle[12] = {
+        x0, y0, z0, 1.0f,
+        x1, y1, z1, 1.0f,
+        x2, y2, z2, 1.0f
+    };
 
-    floatVectorPushBack( &points, x1 );
-    floatVectorPushBack( &points, y1 );
-    floatVectorPushBack( &points, z1 );
-    floatVectorPushBack( &points, 1.0 );
+    floatVectorPushBackN( &shape->points, triangle, 12 );
+}
 
-    floatVectorPushBack( &normals, nx1 );
-    floatVectorPushBack( &normals, ny1 );
-    floatVectorPushBack( &normals, nz1 );
+///
+// gets a view of the vertex points of a shape
+///
+ShapeView shapeVertexView (const ShapeBuilder *shape)
+{
+    ShapeView view;
+    view.data = shape->points.vec;
+    view.count = floatVectorSize(&shape->points);
+    return view;
+}
 
-    floatVectorPushBack( &points, x2 );
-    floatVectorPushBack( &points, y2 );
-    floatVectorPushBack( &points, z2 );
-    floatVectorPushBack( &points, 1.0 );
+///
+// gets a view of the normals of a shape
+///
+ShapeView shapeNormalView (const ShapeBuilder *shape)
+{
+    ShapeView view;
+    view.data = shape->normals.vec;
+    view.count = floatVectorSize(&shape->normals);
+    return view;
+}
 
-    floatVectorPushBack( &normals, nx2 );
-    floatVectorPushBack( &normals, ny2 );
-    floatVectorPushBack( &normals, nz2 );
+///
+// gets a view of the texture coords of a shape
+///
+ShapeView shapeUVView (const ShapeBuilder *shape)
+{
+    ShapeView view;
+    view.data = shape->uv.vec;
+    view.count = floatVectorSize(&shape->uv);
+    return view;
+}
 
+///
+// gets a view of the indices of a shape
+///
+IndexView shapeIndexView (const ShapeBuilder *shape)
+{
+    IndexView view;
+    view.data = shape->indices.vec;
+    view.count = indexVectorSize(&shape->indices);
+    return view;
 }
 
 ///
-// adds only a triangle's vertices to object
+// gets the type of the elements of a shape; 16 bit indices reach 65,535 
+// vertices, so only meshes bigger than that need 32 bits
 ///
-void addTriangleVertices(    
-    float x0, float y0, float z0,
-    float x1, float y1, float z1,
-    float x2, float y2, float z2 )
+GLenum shapeIndexType (const ShapeBuilder *shape)
 {
-    floatVectorPushBack( &points, x0 );
-    floatVectorPushBack( &points, y0 );
-    floatVectorPushBack( &points, z0 );
-    floatVectorPushBack( &points, 1.0 );
+    unsigned int largest = shape->maxIndex;
 
-    floatVectorPushBack( &points, x1 );
-    floatVectorPushBack( &points, y1 );
-    floatVectorPushBack( &points, z1 );
-    floatVectorPushBack( &points, 1.0 );
+    // without indices there is one element per vertex
+    if (indexVectorSize(&shape->indices) == 0 && shapeVertices(shape) > 0) {
+        largest = shapeVertices(shape) - 1;
+    }
 
-    floatVectorPushBack( &points, x2 );
-    floatVectorPushBack( &points, y2 );
-    floatVectorPushBack( &points, z2 );
-    floatVectorPushBack( &points, 1.0 );
+    return largest <= 0xFFFF ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
 }
 
 ///
-// gets the vertex points for the current shape
+// gets the element array of a shape, in the type given by shapeIndexType()
 ///
-float *getVertices ()
+ElementArray shapeElementArray (ShapeBuilder *shape)
 {
+    ElementArray elements;
+    int indexed = indexVectorSize(&shape->indices) > 0;
     int i;
 
-    // delete the old point array of we have one
-    if (pointArray) {
-        free( pointArray );
+    elements.type = shapeIndexType(shape);
+    elements.count = indexed ? (int) indexVectorSize(&shape->indices)
+                             : shapeVertices(shape);
+    elements.size = elements.count *
+        (elements.type == GL_UNSIGNED_SHORT ? sizeof(GLushort)
+                                            : sizeof(GLuint));
+
+    // wide indices are handed out as they are
+    if (indexed && elements.type == GL_UNSIGNED_INT) {
+        elements.data = shape->indices.vec;
+        return elements;
     }
-    
-    // create and fill a new point array
-    pointArray = (float *) malloc(
-        floatVectorSize(&points) * sizeof(float) );
-    if( pointArray == 0 ) {
-        perror( "point allocation failed" );
+
+    // delete the old element array if we have one
+    if (shape->elementArray) {
+        free( shape->elementArray );
+        shape->elementArray = 0;
+    }
+
+    if (elements.count == 0) {
+        elements.data = 0;
+        return elements;
+    }
+
+    // create and fill a new element array
+    shape->elementArray = malloc( elements.size );
+    if( shape->elementArray == 0 ) {
+        perror( "element allocation failed" );
 	exit( 1 );
     }
-    for (i=0; i < points.size; i++) {
-        pointArray[i] = points.vec[i];
+
+    if (elements.type == GL_UNSIGNED_SHORT) {
+        GLushort *narrow = (GLushort *) shape->elementArray;
+        for (i=0; i < elements.count; i++) {
+            narrow[i] = indexed ? shape->indices.vec[i] : i;
+        }
+    } else {
+        GLuint *wide = (GLuint *) shape->elementArray;
+        for (i=0; i < elements.count; i++) {
+            wide[i] = i;
+        }
     }
-        
-    return pointArray;
+
+    elements.data = shape->elementArray;
+    return elements;
 }
 
 ///
-// gets the normals for the current shape
+// reorders the indexed triangles of a shape for the vertex cache
 ///
-float *getNormals ()
+void shapeOptimizeVertexCache (ShapeBuilder *shape)
 {
-    int i;
+    int count = indexVectorSize(&shape->indices);
 
-    // delete the old normal array if we have one
-    if (normalArray) {
-        free( normalArray );
-    }
-    
-    // create and fill a new normal array
-    normalArray = (float *) malloc(
-        floatVectorSize(&normals) * sizeof(float) );
-    if( normalArray == 0 ) {
-        perror( "normal allocation failed" );
-	exit( 1 );
+    if (count > 0) {
+        optimizeVertexCache( shape->indices.vec, count, shape->maxIndex + 1 );
     }
-    for (i=0; i < normals.size; i++) {
-        normalArray[i] = normals.vec[i];
+}
+
+///
+// gets the average cache miss ratio of the indexed triangles of a shape
+///
+float shapeACMR (const ShapeBuilder *shape, int cacheSize)
+{
+    int count = indexVectorSize(&shape->indices);
+
+    if (count == 0) {
+        return 0.0f;
     }
-    
-    return normalArray;
+    return vertexCacheACMR( shape->indices.vec, count, shape->maxIndex + 1,
+                            cacheSize );
 }
 
 ///
-// gets the texture coords for the current shape
+// gets the vertex points for a shape
 ///
-float *getUV ()
+float *shapeGetVertices (ShapeBuilder *shape)
+{
+    return shape->points.vec;
+}
+
+///
+// gets the normals for a shape
+///
+float *shapeGetNormals (ShapeBuilder *shape)
+{
+    return shape->normals.vec;
+}
+
+///
+// gets the texture coords for a shape
+///
+float *shapeGetUV (ShapeBuilder *shape)
+{
+    return shape->uv.vec;
+}
+
+///
+// gets the array of elements for a shape
+///
+GLushort *shapeGetElements (ShapeBuilder *shape)
 {
     int i;
 
-    // delete the old uv array if we have one
-    if (uvArray) {
-        free( uvArray );
+    // delete the old point array of we have one
+    if (shape->elemArray) {
+        free( shape->elemArray );
     }
-    
-    // create and fill a new uv array
-    uvArray = (float *) malloc(
-        floatVectorSize(&uv) * sizeof(float) );
-    if( uvArray == 0 ) {
-        perror( "uv allocation failed" );
+
+    // create and fill a new point array
+    shape->elemArray = (GLushort *) malloc(
+        floatVectorSize(&shape->points) * sizeof(GLushort) );
+    if( shape->elemArray == 0 ) {
+        perror( "element allocation failed" );
 	exit( 1 );
     }
-    for (i=0; i < uv.size; i++) {
-        uvArray[i] = uv.vec[i];
+    for (i=0; i < shape->points.size; i++) {
+        shape->elemArray[i] = i;
     }
-    
-    return uvArray;
+
+    return shape->elemArray;
 }
 
 ///
-// gets the  array of elements for the  current shape
+// gets the array of indices added with shapeAddIndexedTriangle() for a
+// shape
 ///
-GLushort *getElements ()
+GLushort *shapeGetIndices (ShapeBuilder *shape)
 {
     int i;
 
-    // delete the old point array of we have one
-    if (elemArray) {
-        free( elemArray );
+    // delete the old index array if we have one
+    if (shape->indexArray) {
+        free( shape->indexArray );
     }
-    
-    // create and fill a new point array
-    elemArray = (GLushort *) malloc(
-        floatVectorSize(&points) * sizeof(GLushort) );
-    if( elemArray == 0 ) {
-        perror( "element allocation failed" );
+
+    // create and fill a new index array
+    shape->indexArray = (GLushort *) malloc(
+        indexVectorSize(&shape->indices) * sizeof(GLushort) );
+    if( shape->indexArray == 0 ) {
+        perror( "index allocation failed" );
 	exit( 1 );
     }
-    for (i=0; i < points.size; i++) {
-        elemArray[i] = i;
+    for (i=0; i < shape->indices.size; i++) {
+        shape->indexArray[i] = shape->indices.vec[i];
     }
-    
-    return elemArray;
+
+    return shape->indexArray;
+}
+
+///
+// returns number of indices in a shape
+///
+int shapeIndices (const ShapeBuilder *shape)
+{
+    return indexVectorSize(&shape->indices);
+}
+
+///
+// returns number of vertices in a shape
+///
+int shapeVertices (const ShapeBuilder *shape)
+{
+    return floatVectorSize(&shape->points) / 4;
+}
+
+///
+// The original interface, working on the default builder
+///
+
+///
+// gets the default builder used by the functions below
+///
+ShapeBuilder *defaultShapeBuilder ()
+{
+    return &defaultShape;
+}
+
+///
+// clear the current shape
+///
+void clearShape ()
+{
+    shapeClear( &defaultShape );
+}
+
+///
+// adds a single vertex to the current shape
+///
+int addVertex(float x, float y, float z, float nx, float ny, float nz,
+    float u, float v)
+{
+    return shapeAddVertex( &defaultShape, x, y, z, nx, ny, nz, u, v );
+}
+
+///
+// adds a triangle made of three vertices already added with addVertex()
+///
+void addIndexedTriangle(int i0, int i1, int i2)
+{
+    shapeAddIndexedTriangle( &defaultShape, i0, i1, i2 );
+}
+
+///
+// adds a triangle to the current shape
+///
+void addTriangleWithTexCoords(float x0, float y0, float z0, float u0, float v0,
+                  float x1, float y1, float z1, float u1, float v1,
+                  float x2, float y2, float z2, float u2, float v2)
+{
+    shapeAddTriangleWithTexCoords( &defaultShape,
+        x0, y0, z0, u0, v0, x1, y1, z1, u1, v1, x2, y2, z2, u2, v2 );
+}
+
+///
+// adds a triangle to the current shape using calculated normals
+///
+void addTriangle(
+    float x0, float y0, float z0,
+    float x1, float y1, float z1,
+    float x2, float y2, float z2 )
+{
+    shapeAddTriangle( &defaultShape,
+        x0, y0, z0, x1, y1, z1, x2, y2, z2 );
+}
+
+///
+// adds a triangle to the current shape using supplied normals
+///
+void addTriangleWithNorms(
+    float x0, float y0, float z0,
+    float x1, float y1, float z1,
+    float x2, float y2, float z2,
+    float nx0, float ny0, float nz0,
+    float nx1, float ny1, float nz1,
+    float nx2, float ny2, float nz2 )
+{
+    shapeAddTriangleWithNorms( &defaultShape,
+        x0, y0, z0, x1, y1, z1, x2, y2, z2,
+        nx0, ny0, nz0, nx1, ny1, nz1, nx2, ny2, nz2 );
+}
+
+///
+// adds only a triangle's vertices to the current shape
+///
+void addTriangleVertices(
+    float x0, float y0, float z0,
+    float x1, float y1, float z1,
+    float x2, float y2, float z2 )
+{
+    shapeAddTriangleVertices( &defaultShape,
+        x0, y0, z0, x1, y1, z1, x2, y2, z2 );
+}
+
+///
+// gets the vertex points for the current shape
+///
+float *getVertices ()
+{
+    return shapeGetVertices( &defaultShape );
+}
+
+///
+// gets the normals for the current shape
+///
+float *getNormals ()
+{
+    return shapeGetNormals( &defaultShape );
+}
+
+///
+// gets the texture coords for the current shape
+///
+float *getUV ()
+{
+    return shapeGetUV( &defaultShape );
+}
+
+///
+// gets the  array of elements for the  current shape
+///
+GLushort *getElements ()
+{
+    return shapeGetElements( &defaultShape );
+}
+
+///
+// gets the array of indices for the current shape
+///
+GLushort *getIndices ()
+{
+    return shapeGetIndices( &defaultShape );
+}
+
+///
+// returns number of indices in current shape
+///
+int nIndices ()
+{
+    return shapeIndices( &defaultShape );
 }
 
 ///
@@ -321,5 +625,5 @@ GLushort *getElements ()
 ///
 int nVertices ()
 {
-    return floatVectorSize(&points) / 4;
+    return shapeVertices( &defaultShape );
 }
@@ -0,0 +1,125 @@
+///
+// terrainVertex.c
+//
+// Routines for packing vertices into the compact terrain vertex format
+//
+// This code can be compiled as either C or C++.
+//
+// @author T. Wilgenbusch
+///
+
+#include "terrainVertex.h"
+
+#ifdef __cplusplus
+#include <cmath>
+#else
+#include <math.h>
+#endif
+
+///
+// packSnorm - rounds a value from -1 to 1 to a normalized signed byte
+///
+static GLbyte packSnorm(float v)
+{
+    if(v > 1.0f)
+    {
+        v = 1.0f;
+    }
+    if(v < -1.0f)
+    {
+        v = -1.0f;
+    }
+    return (GLbyte)lrintf(v * 127.0f);
+}
+
+///
+// signNotZero - the sign of a value, treating 0 as positive
+///
+static float signNotZero(float v)
+{
+    return v < 0.0f ? -1.0f : 1.0f;
+}
+
+///
+// encodeOctahedral - encodes a normal into two bytes
+//
+// The normal is projected onto the octahedron |x| + |y| + |z| = 1; the 
+// upper half (y >= 0) maps straight onto the x/z square and the lower half 
+// is folded out over its corners. Terrain normals all point up, so they 
+// only ever use the inner diamond.
+//
+// @param nx, ny, nz - the normal; need not be normalized
+// @param out - the two encoded bytes
+///
+void encodeOctahedral(float nx, float ny, float nz, GLbyte out[2])
+{
+    float sum = fabsf(nx) + fabsf(ny) + fabsf(nz);
+    float u = 0.0f;
+    float v = 0.0f;
+
+    if(sum > 0.0f)
+    {
+        u = nx / sum;
+        v = nz / sum;
+
+        if(ny < 0.0f)
+        {
+            float fu = (1.0f - fabsf(v)) * signNotZero(u);
+            float fv = (1.0f - fabsf(u)) * signNotZero(v);
+            u = fu;
+            v = fv;
+        }
+    }
+
+    out[0] = packSnorm(u);
+    out[1] = packSnorm(v);
+}
+
+///
+// decodeOctahedral - decodes two bytes back into a unit normal
+//
+// @param in - the two encoded bytes
+// @param n - the decoded unit normal
+///
+void decodeOctahedral(const GLbyte in[2], float n[3])
+{
+    float u = in[0] / 127.0f;
+    float v = in[1] / 127.0f;
+
+    n[0] = u;
+    n[1] = 1.0f - fabsf(u) - fabsf(v);
+    n[2] = v;
+
+    if(n[1] < 0.0f)
+    {
+        n[0] = (1.0f - fabsf(v)) * signNotZero(u);
+        n[2] = (1.0f - fabsf(u)) * signNotZero(v);
+    }
+
+    float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    n[0] /= length;
+    n[1] /= length;
+    n[2] /= length;
+}
+
+///
+// packTerrainVertex - packs a vertex of a chunk's grid
+//
+// @param height - the height of the vertex, in steps of 1/HEIGHT_PRECISION
+// @param morph - the height the vertex morphs to, in the same steps
+// @param nx, ny, nz - the normal of the vertex; need not be normalized
+//
+// @return The packed vertex
+///
+TerrainVertex packTerrainVertex(int height, int morph,
+    float nx, float ny, float nz)
+{
+    TerrainVertex vertex;
+
+    vertex.height = (GLshort)height;
+    vertex.morph = (GLshort)morph;
+    encodeOctahedral(nx, ny, nz, vertex.normal);
+    vertex.pad[0] = vertex.pad[1] = 0;
+
+    return vertex;
+}
@@ -0,0 +1,360 @@
+///
+// vertexCache.c
+//
+// Reordering of indexed triangle meshes for the GPU's post-transform vertex
+// cache and for vertex fetch, and a simulation of the cache to measure them.
+//
+// This code can be compiled as either C or C++.
+//
+// @author T. Wilgenbusch
+///
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+#include <cmath>
+#else
+#include <math.h>
+#endif
+
+#include "vertexCache.h"
+
+// The LRU cache the triangle order is scored against, and the weights of
+// the score; these are the values Forsyth's linear-speed vertex cache
+// optimization suggests, which suit any cache of 16 or more entries
+#define FORSYTH_CACHE_SIZE 32
+#define CACHE_DECAY_POWER 1.5f
+#define LAST_TRIANGLE_SCORE 0.75f
+#define VALENCE_BOOST_SCALE 2.0f
+#define VALENCE_BOOST_POWER 0.5f
+
+///
+// allocate - mallocs a block, exiting if that fails
+//
+// @param size - the size of the block in bytes
+//
+// @return The block
+///
+static void *allocate(size_t size)
+{
+    void *block = malloc(size > 0 ? size : 1);
+    if(block == NULL)
+    {
+        perror( "vertex cache allocation failed" );
+        exit( 1 );
+    }
+    return block;
+}
+
+///
+// vertexScore - how much drawing a triangle with a vertex next would help
+//
+// Vertices still in the cache score by how recently they were used; those
+// of the last triangle get a fixed, lower score so that strips do not just
+// bounce back and forth. Vertices with few triangles left get a boost, so
+// they are finished off rather than left behind to be transformed again.
+//
+// @param position - the position of the vertex in the cache, or -1
+// @param remaining - the number of triangles still to draw with the vertex
+//
+// @return The score of the vertex
+///
+static float vertexScore(int position, int remaining)
+{
+    float score = 0.0f;
+
+    if(remaining == 0)
+    {
+        return -1.0f;
+    }
+
+    if(position >= 0)
+    {
+        if(position < 3)
+        {
+            score = LAST_TRIANGLE_SCORE;
+        }
+        else
+        {
+            float scale = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+            score = powf(1.0f - (position - 3) * scale, CACHE_DECAY_POWER);
+        }
+    }
+
+    return score +
+        VALENCE_BOOST_SCALE * powf((float)remaining, -VALENCE_BOOST_POWER);
+}
+
+///
+// optimizeVertexCache - reorders the triangles of a mesh for the GPU's
+// post-transform vertex cache, using Forsyth's greedy algorithm: every step
+// draws the best scoring triangle of those using a vertex in a simulated
+// cache, so the mesh is drawn in compact patches instead of long rows whose
+// vertices have left the cache by the time the next row needs them
+//
+// @param indices - the indices of the triangles; reordered in place
+// @param indexCount - the number of indices
+// @param vertexCount - the number of vertices the indices refer to
+///
+void optimizeVertexCache(unsigned int *indices, int indexCount,
+    int vertexCount)
+{
+    int triangleCount = indexCount / 3;
+    int cache[FORSYTH_CACHE_SIZE + 3];
+    int cacheCount = 0;
+
+    if(triangleCount == 0)
+    {
+        return;
+    }
+
+    int *remaining = (int *)allocate(vertexCount * sizeof(int));
+    int *offset = (int *)allocate(vertexCount * sizeof(int));
+    int *adjacency = (int *)allocate(indexCount * sizeof(int));
+    int *position = (int *)allocate(vertexCount * sizeof(int));
+    float *score = (float *)allocate(vertexCount * sizeof(float));
+    float *triangleScore = (float *)allocate(triangleCount * sizeof(float));
+    char *drawn = (char *)allocate(triangleCount);
+    unsigned int *output = (unsigned int *)allocate(
+        indexCount * sizeof(unsigned int));
+
+    // List the triangles of every vertex
+    memset(remaining, 0, vertexCount * sizeof(int));
+    for(int i = 0; i < triangleCount * 3; i++)
+    {
+        remaining[indices[i]]++;
+    }
+
+    for(int v = 0, total = 0; v < vertexCount; v++)
+    {
+        offset[v] = total;
+        total += remaining[v];
+        remaining[v] = 0;
+    }
+
+    for(int i = 0; i < triangleCount * 3; i++)
+    {
+        unsigned int v = indices[i];
+        adjacency[offset[v] + remaining[v]++] = i / 3;
+    }
+
+    for(int v = 0; v < vertexCount; v++)
+    {
+        position[v] = -1;
+        score[v] = vertexScore(-1, remaining[v]);
+    }
+
+    int best = -1;
+    float bestScore = -1.0f;
+    for(int t = 0; t < triangleCount; t++)
+    {
+        const unsigned int *triangle = indices + t * 3;
+
+        drawn[t] = 0;
+        triangleScore[t] =
+            score[triangle[0]] + score[triangle[1]] + score[triangle[2]];
+        if(triangleScore[t] > bestScore)
+        {
+            best = t;
+            bestScore = triangleScore[t];
+        }
+    }
+
+    int next = 0;
+    for(int count = 0; count < triangleCount; count++)
+    {
+        // Nothing in the cache is left to draw; carry on with the first
+        // triangle not yet drawn
+        if(best < 0)
+        {
+            while(drawn[next])
+            {
+                next++;
+            }
+            best = next;
+        }
+
+        const unsigned int *triangle = indices + best * 3;
+        drawn[best] = 1;
+        memcpy(output + count * 3, triangle, 3 * sizeof(unsigned int));
+
+        for(int k = 0; k < 3; k++)
+        {
+            // Take the triangle off its vertex's list
+            unsigned int v = triangle[k];
+            int *list = adjacency + offset[v];
+            int last = --remaining[v];
+
+            for(int i = 0; i <= last; i++)
+            {
+                if(list[i] == best)
+                {
+                    list[i] = list[last];
+                    break;
+                }
+            }
+        }
+
+        // The triangle's vertices move to the front of the cache
+        int newCache[FORSYTH_CACHE_SIZE + 3];
+        int newCount = 0;
+
+        for(int k = 0; k < 3; k++)
+        {
+            int v = (int)triangle[k];
+            int seen = 0;
+
+            for(int i = 0; i < newCount; i++)
+            {
+                seen |= newCache[i] == v;
+            }
+            if(!seen)
+            {
+                newCache[newCount++] = v;
+            }
+        }
+
+        for(int i = 0; i < cacheCount; i++)
+        {
+            int v = cache[i];
+
+            if(v != (int)triangle[0] && v != (int)triangle[1] &&
+                v != (int)triangle[2])
+            {
+                newCache[newCount++] = v;
+            }
+        }
+
+        // Rescore whatever is in the cache, or just fell out of it
+        for(int i = 0; i < newCount; i++)
+        {
+            int v = newCache[i];
+
+            position[v] = i < FORSYTH_CACHE_SIZE ? i : -1;
+            score[v] = vertexScore(position[v], remaining[v]);
+        }
+
+        // The next triangle is the best one using a vertex in the cache
+        best = -1;
+        bestScore = -1.0f;
+        for(int i = 0; i < newCount; i++)
+        {
+            int v = newCache[i];
+
+            for(int j = 0; j < remaining[v]; j++)
+            {
+                int t = adjacency[offset[v] + j];
+                const unsigned int *other = indices + t * 3;
+
+                triangleScore[t] =
+                    score[other[0]] + score[other[1]] + score[other[2]];
+                if(triangleScore[t] > bestScore)
+                {
+                    best = t;
+                    bestScore = triangleScore[t];
+                }
+            }
+        }
+
+        cacheCount = newCount < FORSYTH_CACHE_SIZE ?
+            newCount : FORSYTH_CACHE_SIZE;
+        memcpy(cache, newCache, cacheCount * sizeof(int));
+    }
+
+    memcpy(indices, output, triangleCount * 3 * sizeof(unsigned int));
+
+    free(remaining);
+    free(offset);
+    free(adjacency);
+    free(position);
+    free(score);
+    free(triangleScore);
+    free(drawn);
+    free(output);
+}
+
+///
+// optimizeVertexFetch - renumbers the vertices of a mesh in the order its
+// triangles first use them, so vertex fetch walks the vertex buffer mostly
+// forwards; run it after optimizeVertexCache(), and move the vertex data
+// with the remap table
+//
+// @param indices - the indices of the triangles; renumbered in place
+// @param indexCount - the number of indices
+// @param vertexCount - the number of vertices the indices refer to
+// @param remap - the vertexCount new numbers of the vertices; unused
+//        vertices get ~0u
+//
+// @return The number of vertices used by the mesh
+///
+int optimizeVertexFetch(unsigned int *indices, int indexCount,
+    int vertexCount, unsigned int *remap)
+{
+    unsigned int next = 0;
+
+    for(int v = 0; v < vertexCount; v++)
+    {
+        remap[v] = ~0u;
+    }
+
+    for(int i = 0; i < indexCount; i++)
+    {
+        unsigned int v = indices[i];
+
+        if(remap[v] == ~0u)
+        {
+            remap[v] = next++;
+        }
+        indices[i] = remap[v];
+    }
+
+    return (int)next;
+}
+
+///
+// vertexCacheACMR - the average cache miss ratio of a mesh: how many
+// vertices are transformed per triangle drawn, on a FIFO cache like the
+// ones GPUs use. A mesh that never reuses a vertex scores 3; a regular grid
+// can approach 0.5.
+//
+// @param indices - the indices of the triangles
+// @param indexCount - the number of indices
+// @param vertexCount - the number of vertices the indices refer to
+// @param cacheSize - the number of entries in the cache
+//
+// @return The ACMR of the mesh, or 0 if it has no triangles
+///
+float vertexCacheACMR(const unsigned int *indices, int indexCount,
+    int vertexCount, int cacheSize)
+{
+    int triangleCount = indexCount / 3;
+    int misses = 0;
+
+    if(triangleCount == 0)
+    {
+        return 0.0f;
+    }
+
+    // A vertex is still cached if fewer than cacheSize misses have pushed
+    // vertices in since it went in itself
+    int *loaded = (int *)allocate(vertexCount * sizeof(int));
+    for(int v = 0; v < vertexCount; v++)
+    {
+        loaded[v] = -cacheSize - 1;
+    }
+
+    for(int i = 0; i < triangleCount * 3; i++)
+    {
+        unsigned int v = indices[i];
+
+        if(misses - loaded[v] > cacheSize)
+        {
+            loaded[v] = misses++;
+        }
+    }
+
+    free(loaded);
+    return (float)misses / (float)triangleCount;
+}
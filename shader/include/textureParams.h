@@ -20,4 +20,10 @@ int loadTexture (const char *tex_file);
 
 void setUpTexture (GLuint program, int index);
 
+GLuint makeHeightMap (int size);
+
+void updateHeightMap (GLuint texture, int size, const GLushort *texels);
+
+void setUpHeightMap (GLuint program, GLuint texture, int size);
+
 #endif 
@@ -25,6 +25,11 @@ void setUpTransforms( GLuint program,
     GLfloat rotateX, GLfloat rotateY, GLfloat rotateZ,
     GLfloat translateX, GLfloat translateY, GLfloat translateZ );
 
+void setUpTerrain( GLuint program, GLfloat gridStep, GLfloat heightStep );
+
+void setUpLod( GLuint program, GLfloat lodStep,
+    GLfloat morphStart, GLfloat morphEnd );
+
 void clearCamera( GLuint program );
 void setUpCamera( GLuint program,
     GLfloat eyepointX, GLfloat eyepointY, GLfloat eyepointZ,
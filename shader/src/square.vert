@@ -6,14 +6,30 @@
 ///
 
 // INCOMING DATA
-// Homogeneous vertex coordinates
-attribute vec4 vPosition;
+// Grid column and row of the vertex, shared by every chunk
+attribute vec2 vGrid;
 
-// Normal vector at vertex (in model space)
-attribute vec3 vNormal;
+// Packed terrain vertex: height steps, and the height steps the vertex
+// morphs to when the next coarser level takes over
+attribute vec2 vTerrain;
 
-// Texture Coordinates at vertex
-attribute vec2 vTexCoord; // Unused by the the 2D sampler
+// Octahedral-encoded normal vector at vertex (in model space)
+attribute vec2 vNormal;
+
+// The size of one grid step and one height step of a packed vertex
+uniform vec2 terrainStep;
+
+// The grid points between vertices of this level of detail and the
+// camera distances over which the vertices morph into the next level
+uniform float lodStep;
+uniform vec2 morphRange;
+
+// Height map mode: heights and normals come from a texture holding the
+// height steps of the chunk and its apron (offset by 32768) rather than
+// from vTerrain and vNormal
+uniform bool heightMapMode;
+uniform sampler2D heightMap;
+uniform float heightMapSize;
 
 // Model transformations
 uniform vec3 theta;
@@ -76,9 +92,46 @@ varying vec4 modelViewPos;
 // To be interpolated by the fragment shader
 varying vec2 texCoord;
 
+///
+// decodeNormal - unfolds an octahedral-encoded normal
+///
+vec3 decodeNormal( vec2 e )
+{
+    vec3 n = vec3( e.x, 1.0 - abs( e.x ) - abs( e.y ), e.y );
+    if( n.y < 0.0 )
+    {
+        vec2 s = vec2( n.x >= 0.0 ? 1.0 : -1.0, n.z >= 0.0 ? 1.0 : -1.0 );
+        n.xz = ( 1.0 - abs( n.zx ) ) * s;
+    }
+    return normalize( n );
+}
+
+///
+// mapHeight - reads the height steps of a grid point from the height map
+///
+float mapHeight( vec2 g )
+{
+    vec2 uv = ( g + 1.5 ) / heightMapSize;
+    float texel = texture2DLod( heightMap, uv, 0.0 ).r;
+    return floor( texel * 65535.0 + 0.5 ) - 32768.0;
+}
+
+///
+// mapNormal - the normal at a grid point, from the heights on either side
+///
+vec3 mapNormal( vec2 g )
+{
+    vec2 x = vec2( 1.0, 0.0 );
+    vec2 z = vec2( 0.0, 1.0 );
+    float dx = mapHeight( g - x ) - mapHeight( g + x );
+    float dz = mapHeight( g - z ) - mapHeight( g + z );
+    return normalize( vec3( dx * terrainStep.y, 2.0 * terrainStep.x,
+                            dz * terrainStep.y ) );
+}
+
 void main()
 {    
- // Compute the sines and cosines of each rotation about each axis
+    // Compute the sines and cosines of each rotation about each axis
     vec3 angles = radians( theta );
     vec3 c = cos( angles );
     vec3 s = sin( angles );
@@ -134,12 +187,45 @@ void main()
     mat4 modelMat = xlateMat * rxMat * ryMat * rzMat * scaleMat;
     mat4 modelViewMat = viewMat * modelMat;
 
+    // Where the vertex ends up once fully morphed
+    vec2 odd = mod( vGrid / lodStep, 2.0 );
+    vec2 target = vGrid - odd * lodStep;
+
+    // Fetch the heights and normal of the vertex
+    float height = vTerrain.x;
+    float morph = vTerrain.y;
+    vec3 vertexNormal = decodeNormal( vNormal );
+    if( heightMapMode )
+    {
+        height = mapHeight( vGrid );
+        morph = mapHeight( target );
+        vertexNormal = mapNormal( vGrid );
+    }
+
+    // Unpack the vertex; the grid is moved by half a square so each point 
+    // sits on the corner of the square it was generated for
+    vec4 vPosition = vec4( vGrid.x * terrainStep.x - 0.5,
+                           height * terrainStep.y + 0.5,
+                           vGrid.y * terrainStep.x - 0.5, 1.0 );
+
+    // Morph toward the next coarser level as the vertex nears the end of 
+    // this level's range; odd vertices slide onto their even neighbour 
+    // and take its height so the two levels meet without popping. The 
+    // distance is across the ground, as the LOD quadtree measures it
+    float dist = distance( ( modelMat * vPosition ).xz, cPosition.xz );
+    float k = clamp( ( dist - morphRange.x ) / ( morphRange.y - morphRange.x ),
+                     0.0, 1.0 );
+    vec2 grid = mix( vGrid, target, k );
+    vPosition = vec4( grid.x * terrainStep.x - 0.5,
+                      mix( height, morph, k ) * terrainStep.y + 0.5,
+                      grid.y * terrainStep.x - 0.5, 1.0 );
+
     // Transform the vertex location into clip space
     gl_Position =  projMat * viewMat  * modelMat * vPosition;
 
     // The vertex position and normal in model view coords
     vec4 MVP  = ( modelViewMat * vPosition );
-    vec4 MVN  = ( modelViewMat * vec4( vNormal, 0.0) );
+    vec4 MVN  = ( modelViewMat * vec4( vertexNormal, 0.0) );
 
     // The light pos in view coords
     vec4 MVLP = ( viewMat * lightPos );
@@ -177,8 +263,8 @@ void main()
     viewCPos = VCP;
     modelViewPos = MVP;
 
-    // Pass on texture coords; since this is a cube map, we just 
-    // use the original position of the vertex for the sampler
-    texCoord = vPosition.xy;
+    // Pass on texture coords; these are derived from the position, one 
+    // repeat of the texture per square
+    texCoord = vec2( vPosition.x, -vPosition.z );
 }
 
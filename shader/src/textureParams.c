@@ -22,6 +22,9 @@
 // Generic max, may need to add to later
 #define MAX_TEXTURES 20
 
+// The texture unit height maps are bound to, past any loaded texture
+#define HEIGHT_MAP_UNIT MAX_TEXTURES
+
 // Global for holding all the texture id
 GLuint textureIds[MAX_TEXTURES];
 int currentIndex = 0;
@@ -80,3 +83,84 @@ void setUpTexture(GLuint program, int index)
     GLint textureLoc = glGetUniformLocation(program, "texture");
     glUniform1i(textureLoc, index);
 }
+
+///
+// makeHeightMap creates the texture of a height map, with room for size by 
+// size texels of unsigned 16 bit heights; fill it with updateHeightMap()
+//
+// @param size - the number of texels along one side of the map
+//
+// @return the OpenGL id of the texture
+///
+GLuint makeHeightMap(int size)
+{
+    GLuint texture;
+
+    glActiveTexture(GL_TEXTURE0 + HEIGHT_MAP_UNIT);
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    // Every texel is read at its centre, so nothing is filtered
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R16, size, size, 0, GL_RED, 
+        GL_UNSIGNED_SHORT, NULL);
+
+    glActiveTexture(GL_TEXTURE0);
+    return texture;
+}
+
+///
+// updateHeightMap replaces the texels of a height map; regenerating or 
+// editing a chunk only needs this small upload
+//
+// @param texture - the id of the height map, from makeHeightMap()
+// @param size - the number of texels along one side of the map
+// @param texels - the size * size new texels, row by row
+///
+void updateHeightMap(GLuint texture, int size, const GLushort *texels)
+{
+    glActiveTexture(GL_TEXTURE0 + HEIGHT_MAP_UNIT);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    // Rows of 16 bit texels need not start on a 4 byte boundary
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 2);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, GL_RED, 
+        GL_UNSIGNED_SHORT, texels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glActiveTexture(GL_TEXTURE0);
+}
+
+///
+// This function sets up the height map the vertex shader displaces the 
+// terrain by.
+//
+// @param program - The ID of an OpenGL (GLSL) shader program to which
+//    parameter values are to be sent
+// @param texture - The id of the height map, or 0 to take heights from the 
+//    vertices instead
+// @param size - The number of texels along one side of the map
+///
+void setUpHeightMap(GLuint program, GLuint texture, int size)
+{
+    GLint modeLoc = glGetUniformLocation(program, "heightMapMode");
+    glUniform1i(modeLoc, texture != 0);
+
+    if(texture == 0)
+    {
+        return;
+    }
+
+    glActiveTexture(GL_TEXTURE0 + HEIGHT_MAP_UNIT);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glActiveTexture(GL_TEXTURE0);
+
+    GLint mapLoc = glGetUniformLocation(program, "heightMap");
+    GLint sizeLoc = glGetUniformLocation(program, "heightMapSize");
+    glUniform1i(mapLoc, HEIGHT_MAP_UNIT);
+    glUniform1f(sizeLoc, (GLfloat)size);
+}
@@ -113,6 +113,45 @@ void setUpTransforms( GLuint program,
 }
 
 
+///
+// This function sets up the scale of the packed terrain vertices
+//
+// @param program - The ID of an OpenGL (GLSL) shader program to which
+//    parameter values are to be sent
+// @param gridStep - the distance between neighbouring grid points
+// @param heightStep - the height of one step of a packed height
+///
+void setUpTerrain( GLuint program, GLfloat gridStep, GLfloat heightStep )
+{
+    GLuint stepLoc = glGetUniformLocation( program, "terrainStep" );
+
+    // send down to the shader
+    glUniform2f( stepLoc, gridStep, heightStep );
+}
+
+
+///
+// This function sets up the level of detail of the terrain being drawn
+//
+// @param program - The ID of an OpenGL (GLSL) shader program to which
+//    parameter values are to be sent
+// @param lodStep - the grid points between the vertices of the mesh
+// @param morphStart - the camera distance at which vertices start to morph
+//    into the next coarser level
+// @param morphEnd - the camera distance at which they have fully morphed
+///
+void setUpLod( GLuint program, GLfloat lodStep,
+    GLfloat morphStart, GLfloat morphEnd )
+{
+    GLuint stepLoc = glGetUniformLocation( program, "lodStep" );
+    GLuint rangeLoc = glGetUniformLocation( program, "morphRange" );
+
+    // send down to the shader
+    glUniform1f( stepLoc, lodStep );
+    glUniform2f( rangeLoc, morphStart, morphEnd );
+}
+
+
 ///
 // This function clears any changes made to camera parameters, setting the
 // values to the defaults: eyepoint (0.0,3.0,3.0), lookat (1,0,0.0,0.0),
@@ -0,0 +1,110 @@
+///
+// jobSystem.h
+//
+// A work-stealing job system. Each worker thread owns a deque of jobs: it 
+// pushes and pops jobs at one end, and idle workers steal from the other end 
+// of somebody else's deque. Jobs submitted from outside of the workers go 
+// through a shared queue.
+//
+// A job can depend on other jobs, in which case it is not started until all 
+// of them have finished. A job can also have a completion function, which is 
+// run on the main thread (from jobSystemPollCompleted()) once the job has 
+// finished; this is where anything that must happen on the main thread, 
+// like talking to OpenGL, belongs.
+//
+// @author T. Wilgenbusch
+///
+
+#ifndef _JOBSYSTEM_H_
+#define _JOBSYSTEM_H_
+
+#include <stdbool.h>
+
+///
+// A function run by a job, or on completion of a job
+//
+// @param data - the data given to makeJob()
+///
+typedef void (*JobFunction)(void *data);
+
+/// Opaque handle for a job
+typedef struct Job Job;
+
+///
+// jobSystemStart - starts the worker threads
+//
+// @param numWorkers - the number of workers; 0 starts one per core
+///
+void jobSystemStart(int numWorkers);
+
+///
+// jobSystemStop - stops the workers once they have drained the queue; 
+// every job submitted before the call, and any job those submit, is run 
+// before this returns
+///
+void jobSystemStop();
+
+///
+// jobSystemWorkers - the number of running workers
+///
+int jobSystemWorkers();
+
+///
+// makeJob - creates a job; it does not run until it is submitted
+//
+// @param function - the function the job runs on a worker
+// @param onComplete - a function run on the main thread after the job 
+//                     finishes (may be NULL)
+// @param data - passed to both functions
+//
+// @return The new job, owned by the caller until it is submitted
+///
+Job *makeJob(JobFunction function, JobFunction onComplete, void *data);
+
+///
+// jobDependsOn - makes a job wait for another job to finish before it starts
+//
+// @param job - the job waiting; it must not have been submitted yet
+// @param dependency - the job being waited on; if it has been submitted, the 
+//                     caller must still hold a reference from retainJob()
+///
+void jobDependsOn(Job *job, Job *dependency);
+
+///
+// submitJob - hands a job over to the job system, which runs it as soon as 
+// all of its dependencies have finished
+//
+// The caller's reference to the job is given to the job system; call 
+// retainJob() first to keep using the job afterwards.
+//
+// @param job - the job being submitted
+///
+void submitJob(Job *job);
+
+///
+// retainJob - takes an extra reference to a job
+///
+void retainJob(Job *job);
+
+///
+// releaseJob - drops a reference taken with retainJob()
+///
+void releaseJob(Job *job);
+
+///
+// jobFinished - whether a job has finished running (its completion function 
+// may not have been run yet)
+///
+bool jobFinished(Job *job);
+
+///
+// jobSystemPollCompleted - runs the completion functions of finished jobs; 
+// call this regularly from the main thread
+//
+// @param max - the most completion functions to run; 0 runs all of them
+//
+// @return The number of completion functions run
+///
+int jobSystemPollCompleted(int max);
+
+#endif
@@ -0,0 +1,600 @@
+///
+// jobSystem.c
+//
+// A work-stealing job system built on pthreads.
+//
+// Each worker owns a fixed size Chase-Lev deque: the owner pushes and pops at
+// the bottom without taking a lock, and thieves take jobs from the top with
+// a compare-and-swap. Jobs submitted from other threads (and any jobs that do
+// not fit in a full deque) go through a shared, mutex protected queue, which
+// is also where idle workers sleep.
+//
+// @author T. Wilgenbusch
+///
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "jobSystem.h"
+
+// The most workers that will be started
+#define MAX_WORKERS 64
+
+// The number of jobs each worker's deque holds (must be a power of 2)
+#define DEQUE_CAPACITY 1024
+#define DEQUE_MASK (DEQUE_CAPACITY - 1)
+
+// The number of dependents a job has room for before growing
+#define DEFAULT_DEPENDENTS 4
+
+///
+// Job - a unit of work
+//
+// function, onComplete, data - see makeJob()
+// unfinished   - the dependencies that have not finished, plus one until the
+//                job has been submitted; the job is ready at 0
+// refs         - the number of references to the job
+// lock         - spin lock guarding finished and dependents
+// finished     - set once the function has returned
+// dependents   - the jobs waiting on this one
+// next         - link used by the shared and completion queues
+///
+struct Job
+{
+    JobFunction function;
+    JobFunction onComplete;
+    void *data;
+    int unfinished;
+    int refs;
+    int lock;
+    bool finished;
+    Job **dependents;
+    int numDependents;
+    int maxDependents;
+    Job *next;
+};
+
+///
+// JobQueue - a mutex protected FIFO of jobs, linked through Job.next
+///
+typedef struct JobQueue
+{
+    Job *head;
+    Job *tail;
+} JobQueue;
+
+///
+// WorkDeque - a worker's Chase-Lev deque; top is where jobs are stolen,
+// bottom is where the owner pushes and pops
+///
+typedef struct WorkDeque
+{
+    long top;
+    char pad[64 - sizeof(long)];
+    long bottom;
+    Job *jobs[DEQUE_CAPACITY];
+} WorkDeque;
+
+// The workers and their deques
+static pthread_t workers[MAX_WORKERS];
+static WorkDeque *deques[MAX_WORKERS];
+static int numWorkers = 0;
+static bool running = false;
+
+// The shared queue of submitted jobs, and the condition idle workers wait on
+static pthread_mutex_t sharedLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t workAvailable = PTHREAD_COND_INITIALIZER;
+static JobQueue shared = { NULL, NULL };
+static int sleeping = 0;
+
+// The number of ready jobs sitting in any queue or deque
+static int pending = 0;
+
+// Jobs that have finished and have a completion function to run
+static pthread_mutex_t completedLock = PTHREAD_MUTEX_INITIALIZER;
+static JobQueue completed = { NULL, NULL };
+
+// The index of the worker running on this thread, or -1
+static __thread int workerIndex = -1;
+
+///
+// queuePush, queuePop - add to the tail and remove from the head of a
+// JobQueue; the caller holds the queue's lock
+///
+static void queuePush(JobQueue *queue, Job *job)
+{
+    job->next = NULL;
+    if(queue->tail != NULL)
+    {
+        queue->tail->next = job;
+    }
+    else
+    {
+        queue->head = job;
+    }
+    queue->tail = job;
+}
+
+static Job *queuePop(JobQueue *queue)
+{
+    Job *job = queue->head;
+    if(job != NULL)
+    {
+        queue->head = job->next;
+        if(queue->head == NULL)
+        {
+            queue->tail = NULL;
+        }
+    }
+    return job;
+}
+
+///
+// dequePush - pushes a job onto the bottom of a deque; only the owner calls
+// this
+//
+// @return false if the deque is full
+///
+static bool dequePush(WorkDeque *deque, Job *job)
+{
+    long b = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+    long t = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+
+    if(b - t >= DEQUE_CAPACITY)
+    {
+        return false;
+    }
+
+    __atomic_store_n(&deque->jobs[b & DEQUE_MASK], job, __ATOMIC_RELAXED);
+    __atomic_store_n(&deque->bottom, b + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+///
+// dequePop - pops a job off of the bottom of a deque; only the owner calls
+// this
+//
+// @return The job, or NULL if the deque was empty
+///
+static Job *dequePop(WorkDeque *deque)
+{
+    long b = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&deque->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    long t = __atomic_load_n(&deque->top, __ATOMIC_RELAXED);
+
+    if(t > b)
+    {
+        // Empty; put bottom back
+        __atomic_store_n(&deque->bottom, b + 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    Job *job = __atomic_load_n(&deque->jobs[b & DEQUE_MASK], __ATOMIC_RELAXED);
+    if(t == b)
+    {
+        // Last job; race any thieves for it
+        if(!__atomic_compare_exchange_n(&deque->top, &t, t + 1, false,
+            __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        {
+            job = NULL;
+        }
+        __atomic_store_n(&deque->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+    return job;
+}
+
+///
+// dequeSteal - steals a job off of the top of another worker's deque
+//
+// @return The job, or NULL if the deque was empty or another thread won
+///
+static Job *dequeSteal(WorkDeque *deque)
+{
+    long t = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    long b = __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE);
+
+    if(t >= b)
+    {
+        return NULL;
+    }
+
+    Job *job = __atomic_load_n(&deque->jobs[t & DEQUE_MASK], __ATOMIC_RELAXED);
+    if(!__atomic_compare_exchange_n(&deque->top, &t, t + 1, false,
+        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+    {
+        return NULL;
+    }
+    return job;
+}
+
+///
+// lockJob, unlockJob - the spin lock guarding a job's dependents
+///
+static void lockJob(Job *job)
+{
+    while(__atomic_exchange_n(&job->lock, 1, __ATOMIC_ACQUIRE))
+    {
+        while(__atomic_load_n(&job->lock, __ATOMIC_RELAXED))
+        {
+        }
+    }
+}
+
+static void unlockJob(Job *job)
+{
+    __atomic_store_n(&job->lock, 0, __ATOMIC_RELEASE);
+}
+
+///
+// schedule - queues a job that is ready to run; workers push onto their own
+// deque, everybody else uses the shared queue
+///
+static void schedule(Job *job)
+{
+    __atomic_add_fetch(&pending, 1, __ATOMIC_SEQ_CST);
+
+    if(workerIndex >= 0 && dequePush(deques[workerIndex], job))
+    {
+        // Only wake somebody up if they could steal it
+        if(__atomic_load_n(&sleeping, __ATOMIC_SEQ_CST) > 0)
+        {
+            pthread_mutex_lock(&sharedLock);
+            pthread_cond_signal(&workAvailable);
+            pthread_mutex_unlock(&sharedLock);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&sharedLock);
+    queuePush(&shared, job);
+    pthread_cond_signal(&workAvailable);
+    pthread_mutex_unlock(&sharedLock);
+}
+
+///
+// findJob - finds the next job for a worker: its own deque first, then the
+// shared queue, then the other workers' deques
+//
+// @param self - the index of the worker
+// @param victim - where the worker starts looking for jobs to steal
+///
+static Job *findJob(int self, unsigned int *victim)
+{
+    Job *job = dequePop(deques[self]);
+    if(job != NULL)
+    {
+        return job;
+    }
+
+    pthread_mutex_lock(&sharedLock);
+    job = queuePop(&shared);
+    pthread_mutex_unlock(&sharedLock);
+    if(job != NULL)
+    {
+        return job;
+    }
+
+    for(int i = 0; i < numWorkers; i++)
+    {
+        int other = (int)((*victim + i) % numWorkers);
+        if(other != self)
+        {
+            job = dequeSteal(deques[other]);
+            if(job != NULL)
+            {
+                *victim = other;
+                return job;
+            }
+        }
+    }
+
+    *victim += 1;
+    return NULL;
+}
+
+///
+// finishJob - marks a job as finished, starts any dependents that were only
+// waiting on it and hands it to the main thread if it has a completion
+// function
+///
+static void finishJob(Job *job)
+{
+    lockJob(job);
+    __atomic_store_n(&job->finished, true, __ATOMIC_RELEASE);
+    unlockJob(job);
+
+    // Nobody can add dependents once finished is set, so the list is ours
+    for(int i = 0; i < job->numDependents; i++)
+    {
+        Job *dependent = job->dependents[i];
+        if(__atomic_sub_fetch(&dependent->unfinished, 1, __ATOMIC_ACQ_REL) == 0)
+        {
+            schedule(dependent);
+        }
+    }
+
+    if(job->onComplete != NULL)
+    {
+        // The completion queue takes over the job system's reference
+        pthread_mutex_lock(&completedLock);
+        queuePush(&completed, job);
+        pthread_mutex_unlock(&completedLock);
+    }
+    else
+    {
+        releaseJob(job);
+    }
+}
+
+///
+// workerMain - the loop run by every worker thread
+//
+// @param arg - the index of the worker
+///
+static void *workerMain(void *arg)
+{
+    int self = (int)(long)arg;
+    unsigned int victim = (unsigned int)self + 1;
+
+    workerIndex = self;
+
+    while(true)
+    {
+        Job *job = findJob(self, &victim);
+
+        if(job != NULL)
+        {
+            __atomic_sub_fetch(&pending, 1, __ATOMIC_SEQ_CST);
+            job->function(job->data);
+            finishJob(job);
+            continue;
+        }
+
+        // Nothing to do; sleep until a job is scheduled or we are stopped.
+        // We count ourselves as sleeping before checking pending, and
+        // schedule() bumps pending before checking sleeping, so either we see
+        // the new job or schedule() sees us and signals under the lock.
+        pthread_mutex_lock(&sharedLock);
+        if(!running)
+        {
+            pthread_mutex_unlock(&sharedLock);
+            break;
+        }
+        __atomic_add_fetch(&sleeping, 1, __ATOMIC_SEQ_CST);
+        if(__atomic_load_n(&pending, __ATOMIC_SEQ_CST) == 0)
+        {
+            pthread_cond_wait(&workAvailable, &sharedLock);
+        }
+        __atomic_sub_fetch(&sleeping, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&sharedLock);
+    }
+
+    return NULL;
+}
+
+///
+// jobSystemStart - starts the worker threads
+//
+// @param count - the number of workers; 0 starts one per core
+///
+void jobSystemStart(int count)
+{
+    if(count <= 0)
+    {
+        count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if(count <= 0)
+    {
+        count = 1;
+    }
+    if(count > MAX_WORKERS)
+    {
+        count = MAX_WORKERS;
+    }
+
+    running = true;
+    for(int i = 0; i < count; i++)
+    {
+        deques[i] = (WorkDeque *)calloc(1, sizeof(WorkDeque));
+        if(deques[i] == NULL)
+        {
+            perror( "job deque allocation failed" );
+            exit( 1 );
+        }
+    }
+
+    // Workers steal from each other, so every deque must exist first
+    numWorkers = count;
+    for(int i = 0; i < count; i++)
+    {
+        if(pthread_create(&workers[i], NULL, workerMain, (void *)(long)i) != 0)
+        {
+            perror( "worker creation failed" );
+            exit( 1 );
+        }
+    }
+}
+
+///
+// jobSystemStop - stops the workers once they have drained the queue;
+// every job submitted before the call, and any job those submit, is run
+// before this returns
+///
+void jobSystemStop()
+{
+    pthread_mutex_lock(&sharedLock);
+    running = false;
+    pthread_cond_broadcast(&workAvailable);
+    pthread_mutex_unlock(&sharedLock);
+
+    // Running workers may still steal from any deque, so join them all first
+    for(int i = 0; i < numWorkers; i++)
+    {
+        pthread_join(workers[i], NULL);
+    }
+
+    for(int i = 0; i < numWorkers; i++)
+    {
+        free(deques[i]);
+        deques[i] = NULL;
+    }
+    numWorkers = 0;
+}
+
+///
+// jobSystemWorkers - the number of running workers
+///
+int jobSystemWorkers()
+{
+    return numWorkers;
+}
+
+///
+// makeJob - creates a job; it does not run until it is submitted
+//
+// @param function - the function the job runs on a worker
+// @param onComplete - a function run on the main thread after the job
+//                     finishes (may be NULL)
+// @param data - passed to both functions
+//
+// @return The new job, owned by the caller until it is submitted
+///
+Job *makeJob(JobFunction function, JobFunction onComplete, void *data)
+{
+    Job *job = (Job *)malloc(sizeof(Job));
+    if(job == NULL)
+    {
+        perror( "job allocation failed" );
+        exit( 1 );
+    }
+
+    job->function = function;
+    job->onComplete = onComplete;
+    job->data = data;
+    job->unfinished = 1;
+    job->refs = 1;
+    job->lock = 0;
+    job->finished = false;
+    job->dependents = NULL;
+    job->numDependents = 0;
+    job->maxDependents = 0;
+    job->next = NULL;
+    return job;
+}
+
+///
+// jobDependsOn - makes a job wait for another job to finish before it starts
+//
+// @param job - the job waiting; it must not have been submitted yet
+// @param dependency - the job being waited on; if it has been submitted, the
+//                     caller must still hold a reference from retainJob()
+///
+void jobDependsOn(Job *job, Job *dependency)
+{
+    lockJob(dependency);
+
+    // Nothing to wait for if it is already done
+    if(!dependency->finished)
+    {
+        if(dependency->numDependents == dependency->maxDependents)
+        {
+            int max = dependency->maxDependents == 0 ?
+                DEFAULT_DEPENDENTS : dependency->maxDependents * 2;
+            Job **tmp = (Job **)realloc(dependency->dependents,
+                max * sizeof(Job *));
+            if(tmp == NULL)
+            {
+                perror( "job dependent reallocation failed" );
+                exit( 2 );
+            }
+            dependency->dependents = tmp;
+            dependency->maxDependents = max;
+        }
+
+        dependency->dependents[dependency->numDependents++] = job;
+        __atomic_add_fetch(&job->unfinished, 1, __ATOMIC_ACQ_REL);
+    }
+
+    unlockJob(dependency);
+}
+
+///
+// submitJob - hands a job over to the job system, which runs it as soon as
+// all of its dependencies have finished
+//
+// @param job - the job being submitted
+///
+void submitJob(Job *job)
+{
+    // Drop the hold makeJob() put on the job
+    if(__atomic_sub_fetch(&job->unfinished, 1, __ATOMIC_ACQ_REL) == 0)
+    {
+        schedule(job);
+    }
+}
+
+///
+// retainJob - takes an extra reference to a job
+///
+void retainJob(Job *job)
+{
+    __atomic_add_fetch(&job->refs, 1, __ATOMIC_RELAXED);
+}
+
+///
+// releaseJob - drops a reference to a job, freeing it with the last one
+///
+void releaseJob(Job *job)
+{
+    if(__atomic_sub_fetch(&job->refs, 1, __ATOMIC_ACQ_REL) == 0)
+    {
+        free(job->dependents);
+        free(job);
+    }
+}
+
+///
+// jobFinished - whether a job has finished running
+///
+bool jobFinished(Job *job)
+{
+    return __atomic_load_n(&job->finished, __ATOMIC_ACQUIRE);
+}
+
+///
+// jobSystemPollCompleted - runs the completion functions of finished jobs;
+// call this regularly from the main thread
+//
+// @param max - the most completion functions to run; 0 runs all of them
+//
+// @return The number of completion functions run
+///
+int jobSystemPollCompleted(int max)
+{
+    int count = 0;
+
+    while(max == 0 || count < max)
+    {
+        pthread_mutex_lock(&completedLock);
+        Job *job = queuePop(&completed);
+        pthread_mutex_unlock(&completedLock);
+
+        if(job == NULL)
+        {
+            break;
+        }
+
+        job->onComplete(job->data);
+        releaseJob(job);
+        count++;
+    }
+
+    return count;
+}